@@ -17,9 +17,15 @@
 #define EIGEN_MPL2_ONLY // Ensure that Eigen license is MPL2 compatible.
 
 #include "ascent/core/LinkBase.h"
+#include "ascent/core/Random.h"
+#include "ascent/core/ShardedMap.h"
 #include "ascent/core/State.h"
 #include "ascent/core/Vars.h"
 
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
 #define ascModule(module) if (!chai.modules.count(#module)) { chai.add(chaiscript::fun(static_cast<bool (module::*)()>(&module::run)), "run"); \
 chai.add(chaiscript::fun(static_cast<bool (module::*)(const double, const double)>(&module::run)), "run"); \
 chai.add(chaiscript::base_class<asc::Module, std::decay<decltype(*this)>::type>()); \
@@ -63,6 +69,7 @@ namespace asc
       friend class Link;
 
       friend class Simulator;
+      friend class StepAdvisor;
       friend class Stopper;
 
       template <typename E>
@@ -98,6 +105,23 @@ namespace asc
       /** Whether this module wants to stop the simulation, used for building stoppers. */
       bool stop = false;
 
+      /** Lanes of this module's lane states (see Lanes.h) that want to stop, set in check(). Stopped lanes are masked off, so their states
+      * hold their values while the other lanes run on. Once every lane has stopped, stop is set.
+      */
+      LaneMask stop_lanes = LaneMask::Constant(false);
+
+      /** Under deadline pressure, modules with a lower fidelity priority are demoted first (see addFidelity()). */
+      int fidelity_priority = 0;
+
+      /** The current fidelity tier, 0 is full fidelity (see addFidelity()). */
+      size_t fidelity() const { return fidelity_tier; }
+
+      /** Wake this module, if it's asleep (see sleep()), at the start of the next full time step. Linked modules can wake a module. */
+      void wake();
+
+      /** Whether this module is asleep (see sleep()). */
+      bool asleep() const { return sleeping; }
+
       /** Puts this module's simulator in an error state, which will shut down the simulator as soon as possible.
       * @param description  Describe the error. Collected errors are retrieved via the getError() method.
       * @return Always returns false.
@@ -119,7 +143,109 @@ namespace asc
       bool run(const double dt, const double tend) { return simulator.run(dt, tend); }
 
       /** Runs this module's associated simulator at currently set dt and tend values. */
-      bool run() { return simulator.run(); }
+      bool run() { return simulator.run(); }
+
+      /** Begins an incremental run of this module's simulator (see Simulator::begin()), for hosts that advance the simulation themselves.
+      * @param dt  The time step of for the simulator.
+      * @param tend  The end time, after which step() and advanceTo() no longer advance the simulation.
+      */
+      bool begin(const double dt, const double tend = std::numeric_limits<double>::infinity()) { return simulator.begin(dt, tend); }
+
+      /** Advances this module's simulator n full time steps, without setup or initialization. */
+      bool step(const size_t n = 1) { return simulator.step(n); }
+
+      /** Advances this module's simulator until time t, shortening the last time step to land on t. */
+      bool advanceTo(const double t) { return simulator.advanceTo(t); }
+
+      /** Ends an incremental run begun with begin(). */
+      bool end() { return simulator.end(); }
+
+      /** Reserve memory for a number of full time steps of this module's simulator (i.e. its time history), so that running them doesn't reallocate.
+      * Call after begin(), once modules have been initialized and tracking has been set up.
+      */
+      void reserve(const size_t steps) { simulator.reserve(steps); }
+
+      /** Use an exact time base of int64 ticks for this module's simulator (see Simulator::timeBase()), 0 returns to floating point time.
+      * @param resolution  Seconds per tick, the time steps and sampling rates should be multiples of it.
+      */
+      void timeBase(const double resolution) { simulator.timeBase(resolution); }
+
+      /** Let this module's simulator jump over quiescent intervals (see Simulator::jump_quiescent). */
+      void jumpQuiescent(const bool b = true) { simulator.jump_quiescent = b; }
+
+      /** Skip rates of postcalc() and report() of the modules of this module's simulator that declared inputs (see input()). */
+      std::vector<SkipRate> skipRates() { return simulator.skipRates(); }
+
+      /** Demote (or promote) one module of this module's simulator by a fidelity tier (see Simulator::demote()).
+      * @return Returns the changed module, or nullptr if no module could be changed.
+      */
+      Module* demoteFidelity() { return simulator.demote(); }
+      Module* promoteFidelity() { return simulator.promote(); }
+
+      /** Estimate the largest stable and accurate fixed time step of every fixed step integrator for this module's simulator, at the current time.
+      * Initializes the simulator if needed. The simulator's states and time are unchanged.
+      * @param dt  The time step used to estimate the local truncation error by step doubling.
+      * @param tolerance  Allowed local truncation error per step for each state, relative to (1 + |x|).
+      * @param apply  If true, the advised time step for the simulator's integrator is used for the next run() call.
+      */
+      std::vector<StepAdvice> adviseTimeStep(const double dt, const double tolerance, const bool apply = false) { return simulator.advise(dt, tolerance, apply); }
+
+      /** Get the values of all states of this module's simulator, ordered by module creation and then by addIntegrator() calls (every lane of lane states,
+      * followed by the module's captureValues()).
+      * Together with seedStates() this captures the simulator's state, variables that are computed from states are recomputed by update().
+      */
+      std::vector<double> captureStates() { return simulator.captureStates(); }
+
+      /** Set all states of this module's simulator and its time, so that the next run() call continues from them.
+      * Modules are initialized (init()) before the states are set. The integrator is restarted.
+      * @param x  State values, ordered as captureStates(). A simulator built by the same code has the same order.
+      * @param t  The simulator's new time.
+      */
+      bool seedStates(const std::vector<double>& x, const double t) { return simulator.seedStates(x, t); }
+
+      /** Clear the time history and the variable histories of this module's simulator, so that a following run records only its own trajectory. */
+      void clearHistories() { simulator.clearHistories(); }
+
+      /** Write a binary checkpoint of this module's simulator (see Simulator::checkpoint()). */
+      bool saveCheckpoint(const std::string& file) { return simulator.checkpoint(file); }
+
+      /** Restore a checkpoint into this module's simulator, which must have been built by the same code. A following run() call continues from the checkpoint. */
+      bool loadCheckpoint(const std::string& file) { return simulator.restore(file); }
+
+      /** Write a binary checkpoint of this module's simulator to a stream.
+      * @param histories  Without histories, the checkpoint can only roll back this simulator, but its size doesn't grow with the run (see Simulator::checkpoint()).
+      */
+      bool saveCheckpoint(std::ostream& stream, const bool histories = true) { return simulator.checkpoint(stream, histories); }
+      bool loadCheckpoint(std::istream& stream) { return simulator.restore(stream); }
+
+      /** Write checkpoints to file every interval of simulation time during run(), asynchronously. A non-positive interval turns this off. */
+      void checkpointEvery(const double interval, const std::string& file) { simulator.checkpointEvery(interval, file); }
+
+      /** Fork this module's simulator into branches on new simulators (see Simulator::fork()).
+      * @param factory  Builds the model in the given simulator, as this module's model was built.
+      * @param sims  Simulator numbers for the branches.
+      * @return Returns the branches' modules returned by the factory, empty if forking failed.
+      */
+      std::vector<Link<Module>> fork(const std::function<Link<Module>(const size_t sim)>& factory, const std::vector<size_t>& sims);
+
+      /** Capture this module's simulator after initialization, for fast repeated runs (see Simulator::snapshot()). */
+      bool snapshot() { return simulator.snapshot(); }
+
+      /** Reset this module's simulator in place to its snapshot. */
+      bool restoreSnapshot() { return simulator.restoreSnapshot(); }
+
+      /** This module's random number stream, positioned within the simulator's current time step (see Random.h).
+      * Streams are keyed by the simulator's random seed and key (the simulator number by default), and the module's creation order within its simulator,
+      * so draws are reproducible regardless of threads or module execution order. Draws within a time step continue the stream.
+      */
+      Random& random();
+
+      /** Set the base seed of the random streams of all modules in this module's simulator.
+      * @param seed  Base seed.
+      * @param key  Identifies the simulator's streams instead of the simulator number (i.e. an ensemble run index, since ensemble workers reuse simulators).
+      */
+      void randomSeed(const uint64_t seed) { simulator.random_seed = seed; }
+      void randomSeed(const uint64_t seed, const uint64_t key) { simulator.random_seed = seed; simulator.random_key = key; }
 
       /** The simulator's current time. */
       const double& t;
@@ -142,6 +268,26 @@ namespace asc
       template <typename T>
       std::deque<T> history(const std::string& id) { return vars.history<T>(id); }
 
+      /** Set a variable that was defined via define() (ascVar).
+      * @param id  The string identification of the variable.
+      * @param x  The new value, whose type must match the variable's type.
+      */
+      template <typename T>
+      bool set(const std::string& id, const T& x) { return vars.set(id, x); }
+
+      /** Get a variable that was defined via define() (ascVar).
+      * @param id  The string identification of the variable.
+      */
+      template <typename T>
+      T get(const std::string& id) { return vars.get<T>(id); }
+
+      /** Direct access to a variable that was defined via define() (ascVar), for repeated access without lookups (i.e. co-simulation ports).
+      * @param id  The string identification of the variable.
+      * @return Returns nullptr if the variable of type T doesn't exist.
+      */
+      template <typename T>
+      T* variable(const std::string& id) { return vars.getPtr<T>(id); }
+
       /** True if at the first update of the current simulation run.
       * True only for the first pass on update() for the current run() call.
       */
@@ -215,12 +361,10 @@ namespace asc
       {
          module_name = name;
 
-         if (external.count(name) > 0)
+         if (!external.insert(name, this))
             return error("Module::name(const std::string& name): " + name + " was already defined");
 
          chai.add(chaiscript::var(std::ref(*static_cast<T*>(this))), name);
-
-         external[name] = this;
          return true;
       }
 
@@ -233,6 +377,9 @@ namespace asc
       /** This Module's unique identification across all simulators. */
       const size_t module_id;
 
+      /** This Module's creation order within its simulator, which (unlike module_id) doesn't depend upon other simulators' modules. */
+      const size_t local_id;
+
       /** Generate a Link<T> container from this class; similar to std::shared_from_this(). */
       template <typename T>
       Link<T> linkFromThis()
@@ -301,6 +448,14 @@ namespace asc
       */
       void stopSimulation(bool b = true) { simulator.stop_simulation = b; }
 
+      /** Select the integrator for states subsequently added to this module via addIntegrator(), instead of the simulator's integrator.
+      * This allows cheap integrators for slow states to be mixed with high order integrators. The selected integrator's states are only
+      * propagated at its own stage times, which must coincide with stage times of the simulator's integrator (see IntegratorGroup).
+      * Only the simulator's integrator adapts the time step.
+      */
+      template <typename T>
+      void useIntegrator() { integrator_group = simulator.integratorGroup<T>(); }
+
       /** Add a state and its derivative to be integrated.
       * @param x  State.
       * @param xd  State derivative.
@@ -308,6 +463,9 @@ namespace asc
       * The default negative tolerance means that this state will not be considered for adaptive stepping, even if an adaptive solver is used.
       */
       void addIntegrator(double &x, double &xd, const double tolerance = -1.0);
+      void addIntegrator(float &x, float &xd, const double tolerance = -1.0); // single precision state, to reduce the memory of large models
+      void addIntegrator(long double &x, long double &xd, const double tolerance = -1.0); // extended precision state, for long duration or ill conditioned models
+      void addIntegrator(Lanes &x, Lanes &xd, const double tolerance = -1.0); // lockstep ensemble lanes (see Lanes.h), requires a fixed step integrator
 
       /** Add a std::vector, std::deque, Eigen::Vector3d, etc. to be integrated.
       * @param x  State vector.
@@ -322,9 +480,61 @@ namespace asc
             addIntegrator(x[i], xd[i], tolerance);
       }
 
+      /** Declare an input for change detection. Once a module has inputs, its postcalc() and report() are skipped at full time steps where none of its
+      * inputs changed (bitwise) since the last call of that phase, except at the first and last report of a run. Only declare inputs if postcalc()
+      * and report() depend on nothing else (i.e. not on time). Skip rates are reported by skipRates().
+      * @param x  A variable, of this module or of a linked module, whose memory outlives this module's use of it. Must be trivially copyable.
+      */
+      template <typename T>
+      void input(const T& x)
+      {
+         static_assert(std::is_trivially_copyable<T>::value, "Module::input - inputs must be trivially copyable, use input(data, n) for contiguous arrays.");
+         input(&x, 1);
+      }
+
+      /** Declare a contiguous array of inputs (i.e. the data() of a fixed size Eigen vector), see input(x). */
+      template <typename T>
+      void input(const T* data, const size_t n) { addInput(reinterpret_cast<const unsigned char*>(data), n * sizeof(T)); }
+
+      /** Declare a variable of a linked module that was defined via define() (ascVar) as an input, see input(x). */
+      template <typename T, typename M>
+      bool input(Link<M>& module, const std::string& id)
+      {
+         const T* x = module->template variable<T>(id);
+         if (!x)
+            return error("Module::input - module " + name() + " can't find input <" + id + ">.");
+         input(*x);
+         return true;
+      }
+
+      /** Register a reduced fidelity tier, used by real-time runs under deadline pressure (see Simulator::demote()). Tiers are numbered from 1 in
+      * registration order, tier 0 being full fidelity. At a reduced tier, the tier's update variant replaces update(). A null variant makes the module
+      * skippable at that tier: update() and postcalc() aren't called, so its outputs and state derivatives hold their last values.
+      * update() and postcalc() can also branch on fidelity().
+      */
+      void addFidelity(std::function<void()> update_variant = nullptr) { fidelity_tiers.push_back(update_variant); }
+
       /** For initialization computations. */
       virtual void init() {}
 
+      /** Save data for checkpoints that isn't an integrated state or a variable registered via define() (ascVar), such as data computed in init(). */
+      virtual void checkpoint(std::ostream& /*stream*/) {}
+
+      /** Restore the data written by checkpoint().
+      * @return Return false if the data couldn't be read.
+      */
+      virtual bool restore(std::istream& /*stream*/) { return true; }
+
+      /** Append the values of states that aren't integrated (i.e. propagated by the module itself) to captureStates(), so that they're also
+      * transferred by seedStates() (i.e. between Parareal slices).
+      */
+      virtual void captureValues(std::vector<double>& /*x*/) {}
+
+      /** Set the values appended by captureValues(), starting at x[i].
+      * @return Returns the index after this module's values.
+      */
+      virtual size_t seedValues(const std::vector<double>& /*x*/, const size_t i) { return i; }
+
       /** Called for every kpass internal step (for example: called four times for a 4th order Runge Kutta integrator). */
       virtual void update() { simulator.updates.erase(module_id); }
 
@@ -386,6 +596,44 @@ namespace asc
       */
       bool event(double t_event) { return simulator.event(t_event); }
 
+      /** Register a sampling rate with the simulator's scheduler, instead of calling sample(sdt) every pass.
+      * The simulator is stepped to exact multiples of the sampling rate, with the next sample time computed once per step for all registrations.
+      * @param sdt  The sampling rate.
+      * @return Returns a trigger that is true during the first update() pass of each time step that starts at a sample time.
+      */
+      Trigger addSample(const double sdt);
+
+      /** Register an event time with the simulator's scheduler, instead of calling event(t_event) every pass.
+      * @return Returns a trigger that is true during the first update() pass of the time step that starts at the event time.
+      */
+      Trigger addEvent(const double t_event);
+
+      /** Change the sampling rate of a trigger from addSample(), the next sample is at the next multiple of sdt. */
+      void sampleRate(const Trigger& trigger, const double sdt) { simulator.scheduler.rate(trigger, sdt, simulator.t, simulator.EPS); }
+
+      /** Remove a trigger from addSample() or addEvent(). */
+      void removeTrigger(const Trigger& trigger) { simulator.scheduler.remove(trigger.id); }
+
+      /** Declare this module discrete at a sampling rate, so that update(), postcalc() and reset() are only called at its sample times rather than
+      * on every pass. update() is called on the first pass of a time step that starts at a sample time, postcalc() at the end of a time step that
+      * ends at one, and reset() at the end of each pass in which update() was called. check() and report() are still called every full time step.
+      * Calling discrete() again changes the sampling rate.
+      * @param sdt  The sampling rate.
+      */
+      void discrete(const double sdt);
+
+      /** Put this module to sleep at the end of the current full time step (after its reset()), until it's woken by wake(). A sleeping module is removed from every phase
+      * (update(), postcalc(), check(), report() and reset()) and its states aren't propagated, so they hold their values. Its tracked variables are
+      * still recorded. Modules wake at the start of a full time step.
+      */
+      void sleep();
+
+      /** Sleep until a time, or until woken by wake(). */
+      void sleep(const double t_wake);
+
+      /** Sleep until a trigger from addSample() or addEvent() (of any module of this simulator) fires, or until woken by wake(). */
+      void sleep(const Trigger& trigger);
+
       /** Add an uncontained module as a stopper.
       * Uncontained modules must be added one at a time.
       */
@@ -424,7 +672,7 @@ namespace asc
 
       std::string module_directory = ""; // The directory to where output files will be written.
 
-      static size_t next_module_id; // module id across all simulators
+      static std::atomic<size_t> next_module_id; // module id across all simulators
 
       bool init_called = false;
       bool update_called = false;
@@ -445,7 +693,54 @@ namespace asc
       Vars vars; // contains variable access for the module by string
 
       std::vector<State*> states; // Must be owned by this module. (i.e. addIntegrator should only be called on this module's variables)
-      void propagateStates();
+      std::vector<std::vector<State*>> group_states; // states by integrator group, group_states[0] are integrated by the simulator's integrator
+      size_t integrator_group = 0; // integrator group for states added via addIntegrator()
+
+      std::vector<size_t> triggers; // scheduler registrations, removed with this module
+
+      struct Input
+      {
+         const unsigned char* data;
+         size_t size;
+         size_t offset; // within the last seen values
+      };
+      std::vector<Input> inputs; // change detection (see input())
+      std::vector<unsigned char> seen[2]; // input values at the last postcalc() and report() calls
+      bool seen_valid[2] = { false, false };
+      size_t input_checks[2] = { 0, 0 };
+      size_t input_skips[2] = { 0, 0 };
+      void addInput(const unsigned char* data, const size_t size);
+      bool inputsChanged(const size_t phase); // 0 for postcalc(), 1 for report()
+
+      Trigger discrete_trigger; // sample times of a discrete module
+      bool is_discrete = false;
+      bool dormant() const { return is_discrete && !discrete_trigger; } // a discrete module between its sample times
+
+      bool sleeping = false;
+      bool sleep_pending = false; // in the simulator's to_sleep
+      bool wake_pending = false; // in the simulator's to_wake
+      unsigned sleep_phases = 0; // the simulator's phase maps (and propagate) that held this module when it fell asleep
+      Trigger wake_timer; // for sleep(t_wake), reused
+      size_t wake_on = std::numeric_limits<size_t>::max(); // scheduler registration that wakes this module, if any
+      void fallAsleep();
+      void forgetWaker();
+
+      std::vector<std::function<void()>> fidelity_tiers; // update variants of the reduced fidelity tiers, null if skipped at that tier
+      size_t fidelity_tier = 0;
+
+      template <typename T>
+      void addState(T &x, T &xd, const double tolerance);
+
+      struct LaneState
+      {
+         Lanes* x;
+         Lanes* xd;
+         size_t group; // integrator group
+         Lanes held; // values at the start of the full step, kept by stopped lanes
+      };
+      std::vector<LaneState> lane_states; // masked off by stop_lanes
+
+      void propagateStates(const size_t group = 0);
 
       // manipulators contains modules whose lifetime is to be maintained by this module, and whose modules shouldn't be accessed by other modules.
       std::vector<std::shared_ptr<Module>> manipulators; // Uses std::shared_ptr rather than std::unique_ptr because of std::weak_ptr use for ordering (runBefore()).
@@ -454,7 +749,10 @@ namespace asc
       std::vector<std::pair<size_t, std::string>> tracking; // Vector of pairs of module IDs and their associated variables to be tracked.
       bool track_time = false; // Whether or not to print the simulation time as well.
 
-      std::map<std::string, Module*>& external; // Reference to ModuleCore external map, needed here for templated name function.
+      std::unique_ptr<Random> rng; // created by the first random() call
+      uint64_t rng_seed{}, rng_key{}; // random seed and key the stream was created with
+
+      ShardedMap<std::string, Module*>& external; // Reference to ModuleCore external map, needed here for templated name function.
       static Simulator& getSimulator(const size_t sim); // Needed to avoid publically exposing ModuleCore, used in templated integrator(size_t sim).
    };
 
@@ -468,7 +766,10 @@ namespace asc
       if (s.propagate.size() > 0)
          s.setError("States have already been set for integration. The integrator cannot be changed.");
       else
+      {
          s.integrator = std::make_unique<T>(s.stepper);
+         s.make_integrator = [](Stepper& stepper) -> std::unique_ptr<State> { return std::make_unique<T>(stepper); };
+      }
    }
 
    /** Set the relative error integration tolerance for the entire simulator associated with this module.
@@ -0,0 +1,160 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Binary serialization for checkpoints. Trivially copyable types, std::string, std::vector, std::deque, and Eigen matrices and arrays are supported.
+// write() and read() return false for unsupported types, so that any type can be registered as a variable.
+
+#include <Eigen/Dense>
+
+#include <deque>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace asc
+{
+   class Binary
+   {
+   public:
+      template <typename T>
+      static typename std::enable_if<std::is_trivially_copyable<T>::value, bool>::type write(std::ostream& stream, const T& x)
+      {
+         stream.write(reinterpret_cast<const char*>(&x), sizeof(T));
+         return stream.good();
+      }
+
+      template <typename T>
+      static typename std::enable_if<std::is_trivially_copyable<T>::value, bool>::type read(std::istream& stream, T& x)
+      {
+         stream.read(reinterpret_cast<char*>(&x), sizeof(T));
+         return stream.good();
+      }
+
+      // unsupported types
+      template <typename T>
+      static typename std::enable_if<!std::is_trivially_copyable<T>::value, bool>::type write(std::ostream&, const T&) { return false; }
+
+      template <typename T>
+      static typename std::enable_if<!std::is_trivially_copyable<T>::value, bool>::type read(std::istream&, T&) { return false; }
+
+      static bool write(std::ostream& stream, const std::string& x)
+      {
+         write(stream, static_cast<uint64_t>(x.size()));
+         stream.write(x.data(), x.size());
+         return stream.good();
+      }
+
+      static bool read(std::istream& stream, std::string& x)
+      {
+         uint64_t n{};
+         if (!read(stream, n))
+            return false;
+         x.resize(static_cast<size_t>(n));
+         stream.read(&x[0], n);
+         return stream.good();
+      }
+
+      template <typename T>
+      static bool write(std::ostream& stream, const std::vector<T>& x) { return writeContainer(stream, x); }
+
+      template <typename T>
+      static bool read(std::istream& stream, std::vector<T>& x) { return readContainer(stream, x); }
+
+      static bool write(std::ostream& stream, const std::vector<bool>& x)
+      {
+         return write(stream, std::deque<bool>(x.begin(), x.end()));
+      }
+
+      static bool read(std::istream& stream, std::vector<bool>& x)
+      {
+         std::deque<bool> d;
+         const bool ok = read(stream, d);
+         x.assign(d.begin(), d.end());
+         return ok;
+      }
+
+      template <typename T>
+      static bool write(std::ostream& stream, const std::deque<T>& x) { return writeContainer(stream, x); }
+
+      template <typename T>
+      static bool read(std::istream& stream, std::deque<T>& x) { return readContainer(stream, x); }
+
+      template <typename T, int rows, int cols, int options, int max_rows, int max_cols>
+      static bool write(std::ostream& stream, const Eigen::Matrix<T, rows, cols, options, max_rows, max_cols>& x) { return writeDense(stream, x); }
+
+      template <typename T, int rows, int cols, int options, int max_rows, int max_cols>
+      static bool read(std::istream& stream, Eigen::Matrix<T, rows, cols, options, max_rows, max_cols>& x) { return readDense(stream, x); }
+
+      template <typename T, int rows, int cols, int options, int max_rows, int max_cols>
+      static bool write(std::ostream& stream, const Eigen::Array<T, rows, cols, options, max_rows, max_cols>& x) { return writeDense(stream, x); }
+
+      template <typename T, int rows, int cols, int options, int max_rows, int max_cols>
+      static bool read(std::istream& stream, Eigen::Array<T, rows, cols, options, max_rows, max_cols>& x) { return readDense(stream, x); }
+
+      // Write or read several values in order.
+      template <typename T, typename... Trest>
+      static bool write(std::ostream& stream, const T& first, const Trest&... rest) { return write(stream, first) && write(stream, rest...); }
+
+      template <typename T, typename... Trest>
+      static bool read(std::istream& stream, T& first, Trest&... rest) { return read(stream, first) && read(stream, rest...); }
+
+   private:
+      template <typename D>
+      static bool writeDense(std::ostream& stream, const D& x)
+      {
+         write(stream, static_cast<int64_t>(x.rows()));
+         write(stream, static_cast<int64_t>(x.cols()));
+         stream.write(reinterpret_cast<const char*>(x.data()), x.size() * sizeof(typename D::Scalar));
+         return stream.good();
+      }
+
+      template <typename D>
+      static bool readDense(std::istream& stream, D& x)
+      {
+         int64_t r{}, c{};
+         if (!read(stream, r) || !read(stream, c))
+            return false;
+         if ((D::RowsAtCompileTime != Eigen::Dynamic && r != D::RowsAtCompileTime) || (D::ColsAtCompileTime != Eigen::Dynamic && c != D::ColsAtCompileTime))
+            return false;
+         x.resize(static_cast<Eigen::Index>(r), static_cast<Eigen::Index>(c));
+         stream.read(reinterpret_cast<char*>(x.data()), x.size() * sizeof(typename D::Scalar));
+         return stream.good();
+      }
+
+      template <typename C>
+      static bool writeContainer(std::ostream& stream, const C& x)
+      {
+         bool ok = write(stream, static_cast<uint64_t>(x.size()));
+         for (auto& e : x)
+            ok = ok && write(stream, e);
+         return ok;
+      }
+
+      template <typename C>
+      static bool readContainer(std::istream& stream, C& x)
+      {
+         uint64_t n{};
+         if (!read(stream, n))
+            return false;
+         x.resize(static_cast<size_t>(n));
+         bool ok = true;
+         for (auto& e : x)
+            ok = ok && read(stream, e);
+         return ok;
+      }
+   };
+}
\ No newline at end of file
@@ -50,6 +50,8 @@ namespace asc
 
       bool direct_erase = true; // Whether or not calls to erase should be direct erases, not postponed. Default is true.
 
+      void reserve(const size_t n) { to_erase.reserve(n); } // room for n postponed erases without reallocating
+
       void erase(const T1& key)
       {
          if (direct_erase)
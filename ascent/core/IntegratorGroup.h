@@ -0,0 +1,63 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// States that are integrated with a different scheme than the simulator's integrator (selected per module via Module::useIntegrator<T>()).
+// The simulator's integrator drives the clock. A group has its own stage clock (t, t1, kpass), and its states are propagated
+// only at the simulator's passes whose time matches the group's next stage time. Hence a cheap integrator only does its own
+// number of passes per step. Every stage time of the group's integrator must coincide with a stage time of the simulator's integrator:
+// Euler (stage at t) can be mixed with any integrator, RK2 and the RTAM integrators (stages at t and t + dt/2) can be mixed with RK4, etc.
+// A group with fewer stages completes its step before the simulator's integrator. Until the simulator's step completes, its states are then
+// interpolated linearly between their values at the start and end of the step, so that update() passes at the remaining stage times see
+// values at those times, rather than the end of step values.
+
+#include "ascent/core/DynamicMap.h"
+#include "ascent/core/State.h"
+#include "ascent/core/Stepper.h"
+
+#include <memory>
+#include <typeindex>
+#include <vector>
+
+namespace asc
+{
+   class Module;
+
+   class IntegratorGroup
+   {
+   public:
+      IntegratorGroup(const size_t id, const std::type_index type, double& EPS, double& dtp, double& dt) : id(id), type(type),
+         stepper(EPS, dtp, dt, t, t1, kpass, integrator_initialized) {}
+
+      const size_t id; // index into a module's group_states
+      const std::type_index type; // integrator type
+
+      double t{}; // the time of the group's next stage
+      double t1{};
+      size_t kpass{};
+      bool integrator_initialized = false;
+      bool active = false; // whether the group has stages remaining within the current simulator step
+
+      double t_start{}, t_end{}; // the current simulator step
+      std::vector<double> x_start, x_end; // the group's states at the start and end of the current step, while holding
+      bool holding = false; // whether the group completed its step before the simulator's integrator
+
+      Stepper stepper; // shares EPS, dtp, and dt with the simulator
+
+      std::unique_ptr<State> integrator;
+
+      DynamicMap<size_t, Module*> propagate; // modules with states in this group
+   };
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Lane states for lockstep ensembles: one logical model integrates several parameter variants at once, with one variant per lane.
+// Lane math is element-wise, so Eigen vectorizes states, integration stages, and the model's update() math across the lanes.
+// Define ASCENT_LANES to match the SIMD width (i.e. 4 for AVX, 8 for AVX-512).
+
+#include <Eigen/Dense>
+
+#ifndef ASCENT_LANES
+#define ASCENT_LANES 4
+#endif
+
+namespace asc
+{
+   // Unaligned, so that lanes can be members of modules and states without aligned allocation.
+   using Lanes = Eigen::Array<double, ASCENT_LANES, 1, Eigen::DontAlign>;
+   using LaneMask = Eigen::Array<bool, ASCENT_LANES, 1, Eigen::DontAlign>;
+
+   /** Masks off lanes that have stopped by zeroing their derivative. Modules do this for their lane states after update(), for the lanes
+   * of Module::stop_lanes, and also hold the states of those lanes (multistep integrators would still move them).
+   * @param xd  The state derivative.
+   * @param active  Lanes that are still running.
+   */
+   inline void mask(Lanes& xd, const LaneMask& active) { xd = active.select(xd, 0.0); }
+
+   // Scalar access for the State interface (i.e. value() and derivative()), lane states are represented by their first lane.
+   template <typename T>
+   inline double scalar(const T& x) { return static_cast<double>(x); }
+   inline double scalar(const Lanes& x) { return x(0); }
+
+   template <typename T>
+   inline void scalar(T& x, const double v) { x = static_cast<T>(v); }
+   inline void scalar(Lanes& x, const double v) { x(0) = v; }
+
+   // Per lane access (i.e. for Parareal transfers), scalar types have a single lane.
+   template <typename T>
+   inline size_t lanes(const T&) { return 1; }
+   inline size_t lanes(const Lanes&) { return ASCENT_LANES; }
+
+   template <typename T>
+   inline double lane(const T& x, const size_t) { return static_cast<double>(x); }
+   inline double lane(const Lanes& x, const size_t i) { return x(static_cast<Eigen::Index>(i)); }
+
+   template <typename T>
+   inline void lane(T& x, const size_t, const double v) { x = static_cast<T>(v); }
+   inline void lane(Lanes& x, const size_t i, const double v) { x(static_cast<Eigen::Index>(i)) = v; }
+
+   // Whether a value is zero in every lane (i.e. a derivative, for quiescence detection).
+   template <typename T>
+   inline bool zero(const T& x) { return x == T(0); }
+   inline bool zero(const Lanes& x) { return (x == 0.0).all(); }
+}
\ No newline at end of file
@@ -14,8 +14,11 @@
 
 #pragma once
 
+#include "ShardedMap.h"
+
 #include <map>
 #include <memory>
+#include <mutex>
 
 namespace asc
 {
@@ -29,13 +32,16 @@ namespace asc
 
       static void error(const size_t sim, const std::string& description);
       
-      static std::map<std::string, Module*> external; // registered module names with associated modules IDs (size_t module_id), allowing external access to modules via these names
+      // Registries are shared by all simulators, which can be built and run on separate threads.
+      static ShardedMap<std::string, Module*> external; // registered module names with associated modules, allowing external access to modules via these names
       static Module& getExternal(const std::string& name);
       
-      static std::map<size_t, Module*> accessor; // used to access modules by module_id across all simulators
+      static ShardedMap<size_t, Module*> accessor; // used to access modules by module_id across all simulators
       static Module& getModule(const size_t id);
       
-      static std::map<size_t, std::unique_ptr<Simulator>> simulators;
+      static std::map<size_t, std::unique_ptr<Simulator>> simulators; // only accessed while holding simulators_mutex
+      static std::mutex simulators_mutex;
       static Simulator& getSimulator(const size_t sim);
+      static void eraseSimulator(const size_t sim);
    };
 }
\ No newline at end of file
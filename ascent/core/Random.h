@@ -0,0 +1,186 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Counter-based random numbers (Philox4x32-10, Salmon et al. 2011). A number is a pure function of a key and a counter, so streams
+// need no shared generator state: every module draws from its own stream, keyed by (seed, sim, module), with counters indexed by
+// (time step, draw). Draws are reproducible regardless of thread count, module execution order, or how many numbers other modules draw.
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace asc
+{
+   class Random
+   {
+   public:
+      using Block = std::array<uint32_t, 4>;
+
+      Random() = default;
+
+      /**
+      * @param seed  Base seed (i.e. of an ensemble run).
+      * @param family  Identifies a family of streams (i.e. a simulator).
+      * @param stream  Stream within the family (i.e. a module's creation order within its simulator).
+      */
+      Random(const uint64_t seed, const uint64_t family, const uint32_t stream) : stream(stream)
+      {
+         const uint64_t k = mix(seed + mix(family));
+         key = { static_cast<uint32_t>(k), static_cast<uint32_t>(k >> 32) };
+      }
+
+      /** Position the stream at the start of a time step's numbers, unless it is already within that step. */
+      void seek(const uint64_t step)
+      {
+         if (step == current_step)
+            return;
+         current_step = step;
+         block = 0;
+         used = 4;
+         has_spare = false;
+      }
+
+      uint32_t next32()
+      {
+         if (used == 4)
+         {
+            words = philox(counter(block++), key);
+            used = 0;
+         }
+         return words[used++];
+      }
+
+      double uniform() // [0, 1)
+      {
+         const uint32_t a = next32(); // sequenced, function argument evaluation order is unspecified
+         return toUniform(a, next32());
+      }
+
+      double uniform(const double a, const double b) { return a + (b - a) * uniform(); }
+
+      double normal() // standard normal, Box-Muller
+      {
+         if (has_spare)
+         {
+            has_spare = false;
+            return spare;
+         }
+         const double u1 = uniform(), u2 = uniform();
+         double z0, z1;
+         boxMuller(u1, u2, z0, z1);
+         spare = z1;
+         has_spare = true;
+         return z0;
+      }
+
+      double normal(const double mean, const double sd) { return mean + sd * normal(); }
+
+      // Bulk generation continues the same stream as the scalar methods. Whole blocks are generated in an independent loop
+      // (no state is carried between blocks), which the compiler can vectorize.
+      void uniform(double* x, const size_t n)
+      {
+         size_t i = 0;
+         for (; i < n && used != 4; ++i)
+            x[i] = uniform();
+
+         const size_t blocks = (n - i) / 2;
+         for (size_t b = 0; b < blocks; ++b)
+         {
+            const Block w = philox(counter(block + b), key);
+            x[i + 2 * b] = toUniform(w[0], w[1]);
+            x[i + 2 * b + 1] = toUniform(w[2], w[3]);
+         }
+         block += blocks;
+         i += 2 * blocks;
+
+         for (; i < n; ++i)
+            x[i] = uniform();
+      }
+
+      void normal(double* x, const size_t n)
+      {
+         size_t i = 0;
+         for (; i < n && (has_spare || used != 4); ++i)
+            x[i] = normal();
+
+         const size_t blocks = (n - i) / 2;
+         for (size_t b = 0; b < blocks; ++b)
+         {
+            const Block w = philox(counter(block + b), key);
+            boxMuller(toUniform(w[0], w[1]), toUniform(w[2], w[3]), x[i + 2 * b], x[i + 2 * b + 1]);
+         }
+         block += blocks;
+         i += 2 * blocks;
+
+         for (; i < n; ++i)
+            x[i] = normal();
+      }
+
+      template <typename T>
+      void uniform(T& x) { uniform(x.data(), static_cast<size_t>(x.size())); } // std::vector<double>, Eigen::VectorXd, etc.
+
+      template <typename T>
+      void normal(T& x) { normal(x.data(), static_cast<size_t>(x.size())); }
+
+      static Block philox(Block c, std::array<uint32_t, 2> k)
+      {
+         for (int round = 0; round < 10; ++round)
+         {
+            if (round > 0)
+            {
+               k[0] += 0x9E3779B9u;
+               k[1] += 0xBB67AE85u;
+            }
+            const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c[0];
+            const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c[2];
+            c = { static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k[0], static_cast<uint32_t>(p1),
+               static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k[1], static_cast<uint32_t>(p0) };
+         }
+         return c;
+      }
+
+   private:
+      std::array<uint32_t, 2> key{};
+      uint32_t stream{};
+      uint64_t current_step = ~uint64_t(0);
+      uint32_t block{}; // block within the step
+      Block words{};
+      unsigned used = 4; // words used from the current block
+      double spare{};
+      bool has_spare = false;
+
+      Block counter(const uint32_t b) const { return { b, stream, static_cast<uint32_t>(current_step), static_cast<uint32_t>(current_step >> 32) }; }
+
+      static uint64_t mix(uint64_t z) // splitmix64 finalizer
+      {
+         z += 0x9E3779B97F4A7C15ull;
+         z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+         z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+         return z ^ (z >> 31);
+      }
+
+      static double toUniform(const uint32_t a, const uint32_t b) { return ((static_cast<uint64_t>(a) << 21) ^ (b >> 11)) / 9007199254740992.0; } // 53 bits
+
+      static void boxMuller(const double u1, const double u2, double& z0, double& z1)
+      {
+         const double r = std::sqrt(-2.0 * std::log(1.0 - u1)); // 1 - u1 is in (0, 1]
+         const double theta = 6.283185307179586 * u2;
+         z0 = r * std::cos(theta);
+         z1 = r * std::sin(theta);
+      }
+   };
+}
\ No newline at end of file
@@ -0,0 +1,338 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Real-time paced execution (i.e. operator-in-the-loop testing). Frames are paced to the monotonic clock with absolute wake-up times,
+// so lateness doesn't accumulate. Setup and init() run once (begin()), then each frame advances the simulation to the frame's time
+// (advanceTo()) and calls the host's frame function. Memory for the run's time steps is reserved up front. Optionally, the process's
+// memory is locked and the thread is pinned to a CPU and given a real-time (SCHED_FIFO) priority, which require POSIX (pinning, Linux).
+// Per-frame compute times, deadline misses and jitter (wake-up lateness) are recorded, with histograms.
+// Under deadline pressure, modules that registered reduced fidelity tiers (Module::addFidelity()) are demoted one tier per loaded frame, and
+// promoted again, in reverse order, once frames have slack. Every change is logged. Full fidelity is restored at the end of the run.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+#endif
+
+namespace asc
+{
+   struct RealTimeStatistics
+   {
+      size_t frames{};
+      size_t misses{}; // frames that ended after their deadline (the next frame's wake-up time)
+      size_t resyncs{}; // times the schedule was moved forward because a frame ended more than a period late, the simulation then lags wall-clock time
+
+      double compute_mean{}; // seconds per frame of integration and host work
+      double compute_max{};
+      double jitter_mean{}; // seconds a frame started after its scheduled time
+      double jitter_max{};
+
+      double bin_width{}; // seconds per histogram bin, the last bin also counts everything beyond it
+      std::vector<size_t> compute_histogram;
+      std::vector<size_t> jitter_histogram;
+   };
+
+   struct FidelityChange
+   {
+      double t{}; // simulation time of the change
+      std::string module; // module name
+      size_t from{};
+      size_t to{};
+      double load{}; // compute time of the frame that triggered the change, relative to the period
+   };
+
+   class RealTime
+   {
+   public:
+      /** @param model  A module of the simulator to run.
+      * @param period  Wall-clock seconds per frame.
+      */
+      RealTime(Link<Module> model, const double period) : period(period), model(model) {}
+
+      double period;
+      double speed = 1.0; // simulation seconds per wall-clock second
+
+      bool lock_memory = false; // lock the process's current and future memory (mlockall), so that it isn't paged out
+      int cpu = -1; // pin the running thread to this CPU, if not negative
+      int priority = 0; // run the thread with this SCHED_FIFO priority, if positive
+
+      double bin_width = 50e-6;
+      size_t bins = 200;
+
+      std::function<bool(const double t)> frame; // host work after each frame's integration (i.e. exchanging I/O), returning false ends the run
+
+      double demote_load = 0.8; // demote a module after a frame whose compute time exceeds this fraction of the period
+      double promote_load = 0.5; // promote a module after promote_frames consecutive frames below this fraction of the period
+      size_t promote_frames = 20;
+      bool log_fidelity = true; // also print fidelity changes to the console
+
+      RealTimeStatistics statistics;
+      std::vector<FidelityChange> changes;
+
+      /** Run the model's simulator from its current time to tend, paced to wall-clock time.
+      * @param dt  Time step of the simulator, the last step of a frame is shortened to land on the frame's time.
+      * @return Returns false if the simulation failed or the real-time configuration couldn't be applied.
+      */
+      bool run(const double dt, const double tend)
+      {
+         statistics = RealTimeStatistics{};
+         statistics.bin_width = bin_width;
+         statistics.compute_histogram.assign(std::max<size_t>(bins, 1), 0);
+         statistics.jitter_histogram.assign(std::max<size_t>(bins, 1), 0);
+         changes.clear();
+         slack_frames = 0;
+
+         if (period <= 0.0 || speed <= 0.0)
+            return model->error("RealTime::run - the period and speed must be positive.");
+
+         if (!configure())
+         {
+            restore();
+            return false;
+         }
+
+         if (!model->begin(dt, tend))
+         {
+            model->end();
+            restore();
+            return false;
+         }
+
+         const double t0 = model->t;
+         const double frame_time = period * speed; // simulation time per frame
+         const size_t frames = static_cast<size_t>(std::ceil((tend - t0) / frame_time));
+         model->reserve(static_cast<size_t>(std::ceil((tend - t0) / dt)) + frames + 1); // a frame can shorten one step
+
+         const int64_t period_ns = static_cast<int64_t>(std::llround(period * 1e9));
+         int64_t next = now();
+         bool ok = true;
+         bool stop = false;
+
+         for (size_t k = 1; ok && !stop && !model->last_report; ++k)
+         {
+            const int64_t wake = now();
+
+            ok = model->advanceTo(std::min(t0 + k * frame_time, tend));
+            if (ok && frame)
+               stop = !frame(model->t);
+
+            const int64_t done = now();
+            record(done - wake, std::max<int64_t>(wake - next, 0));
+            if (ok && !stop && !model->last_report)
+               adjustFidelity((done - wake) * 1e-9 / period);
+
+            next += period_ns;
+            if (done > next)
+            {
+               ++statistics.misses;
+               if (done > next + period_ns)
+               {
+                  next = done;
+                  ++statistics.resyncs;
+               }
+            }
+
+            if (ok && !stop && !model->last_report)
+               sleepUntil(next);
+         }
+
+         if (statistics.frames > 0)
+         {
+            statistics.compute_mean /= statistics.frames;
+            statistics.jitter_mean /= statistics.frames;
+         }
+
+         while (Module* module = model->promoteFidelity())
+            log(module, module->fidelity() + 1, 0.0);
+
+         ok = model->end() && ok;
+         restore();
+         return ok;
+      }
+
+   private:
+      Link<Module> model;
+
+      size_t slack_frames = 0;
+
+      bool locked = false;
+#if defined(__unix__)
+      bool scheduled = false;
+      int policy{};
+      sched_param param{};
+#endif
+#if defined(__linux__)
+      bool pinned = false;
+      cpu_set_t affinity{};
+#endif
+
+      static int64_t now()
+      {
+#if defined(__unix__)
+         timespec ts;
+         clock_gettime(CLOCK_MONOTONIC, &ts);
+         return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+         return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+      }
+
+      static void sleepUntil(const int64_t ns)
+      {
+#if defined(__unix__)
+         timespec ts;
+         ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+         ts.tv_nsec = static_cast<long>(ns % 1000000000);
+         while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+         std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ns)));
+#endif
+      }
+
+      void adjustFidelity(const double load)
+      {
+         if (load > demote_load)
+         {
+            slack_frames = 0;
+            if (Module* module = model->demoteFidelity())
+               log(module, module->fidelity() - 1, load);
+         }
+         else if (load < promote_load && ++slack_frames >= promote_frames)
+         {
+            slack_frames = 0;
+            if (Module* module = model->promoteFidelity())
+               log(module, module->fidelity() + 1, load);
+         }
+         else if (load >= promote_load)
+            slack_frames = 0;
+      }
+
+      void log(Module* module, const size_t from, const double load)
+      {
+         changes.push_back(FidelityChange{ model->t, module->name(), from, module->fidelity(), load });
+         if (log_fidelity)
+            std::cout << "RealTime: t = " << model->t << ", " << changes.back().module << " fidelity tier " << from << " -> " << module->fidelity() << " (frame load " << load << ")\n";
+      }
+
+      void record(const int64_t compute_ns, const int64_t jitter_ns)
+      {
+         const double compute = compute_ns * 1e-9;
+         const double jitter = jitter_ns * 1e-9;
+
+         ++statistics.frames;
+         statistics.compute_mean += compute; // summed, averaged at the end of the run
+         statistics.compute_max = std::max(statistics.compute_max, compute);
+         statistics.jitter_mean += jitter;
+         statistics.jitter_max = std::max(statistics.jitter_max, jitter);
+
+         ++statistics.compute_histogram[bin(compute)];
+         ++statistics.jitter_histogram[bin(jitter)];
+      }
+
+      size_t bin(const double x) const
+      {
+         const size_t last = statistics.compute_histogram.size() - 1;
+         if (bin_width <= 0.0)
+            return last;
+         return static_cast<size_t>(std::min(x / bin_width, static_cast<double>(last)));
+      }
+
+      bool configure()
+      {
+#if defined(__unix__)
+         if (lock_memory)
+         {
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+               return model->error("RealTime::run - memory couldn't be locked (mlockall), which may require privileges or a larger memlock limit.");
+            locked = true;
+            prefaultStack();
+         }
+
+#if defined(__linux__)
+         if (cpu >= 0)
+         {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_getaffinity_np(pthread_self(), sizeof(affinity), &affinity);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+               return model->error("RealTime::run - the thread couldn't be pinned to CPU " + std::to_string(cpu) + ".");
+            pinned = true;
+         }
+#else
+         if (cpu >= 0)
+            return model->error("RealTime::run - pinning the thread to a CPU requires Linux.");
+#endif
+
+         if (priority > 0)
+         {
+            pthread_getschedparam(pthread_self(), &policy, &param);
+            sched_param fifo{};
+            fifo.sched_priority = priority;
+            if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &fifo) != 0)
+               return model->error("RealTime::run - the thread couldn't be given SCHED_FIFO priority " + std::to_string(priority) + ", which may require privileges.");
+            scheduled = true;
+         }
+         return true;
+#else
+         if (lock_memory || cpu >= 0 || priority > 0)
+            return model->error("RealTime::run - memory locking, CPU pinning and real-time priority require POSIX.");
+         return true;
+#endif
+      }
+
+      void restore()
+      {
+#if defined(__unix__)
+         if (scheduled)
+            pthread_setschedparam(pthread_self(), policy, &param);
+         scheduled = false;
+
+         if (locked)
+            munlockall();
+#endif
+#if defined(__linux__)
+         if (pinned)
+            pthread_setaffinity_np(pthread_self(), sizeof(affinity), &affinity);
+         pinned = false;
+#endif
+         locked = false;
+      }
+
+      static void prefaultStack()
+      {
+         volatile char stack[64 * 1024]; // touch stack pages now, so that deeper calls during the run don't fault
+         for (size_t i = 0; i < sizeof(stack); i += 4096)
+            stack[i] = 0;
+      }
+   };
+}
\ No newline at end of file
@@ -0,0 +1,243 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Central scheduler of sample rates and events, an alternative to calling sample(sdt) and event(t_event) on every pass of every module.
+// Modules register rates and events once (Module::addSample() and addEvent()), and the scheduler's min-heap yields the next sample or event
+// time once per time step, for all registrations. Registrations that are due at the start of a step are flagged, and a module reads its
+// flag through a Trigger. Removed and changed registrations are left in the heap and skipped (lazy deletion).
+
+#include "ascent/core/Binary.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace asc
+{
+   /** True at its sample or event times, like sample(sdt) and event(t_event): in postcalc(), check() and report() at the end of a time step that ends
+   * at one, and during the first update() pass of a time step that starts at one.
+   */
+   class Trigger
+   {
+   public:
+      Trigger() {}
+      Trigger(const bool* flag, const size_t id) : id(id), flag(flag) {}
+
+      explicit operator bool() const { return flag && *flag; }
+
+      bool valid() const { return flag != nullptr; } // whether this trigger was registered
+
+      size_t id = 0; // registration id within the simulator's scheduler
+
+   private:
+      const bool* flag = nullptr;
+   };
+
+   class Scheduler
+   {
+   public:
+      double resolution = 0.0; // seconds per tick of the simulator's exact time base, if positive (see Simulator::timeBase())
+
+      /** Register a sample rate, sampled at exact multiples of sdt starting from the next multiple at or after time t. */
+      Trigger sample(const double sdt, const double t, const double EPS)
+      {
+         entries.emplace_back();
+         Entry& entry = entries.back();
+         entry.period = sdt;
+         entry.time = multiple(t, sdt, false, EPS);
+         push(entries.size() - 1);
+         return Trigger(&entry.fired, entries.size() - 1);
+      }
+
+      /** Register an absolute event time, which fires once. */
+      Trigger event(const double t_event)
+      {
+         entries.emplace_back();
+         entries.back().time = t_event;
+         push(entries.size() - 1);
+         return Trigger(&entries.back().fired, entries.size() - 1);
+      }
+
+      /** Change a sample rate, the next sample is at the next multiple of sdt after time t. */
+      void rate(const Trigger& trigger, const double sdt, const double t, const double EPS)
+      {
+         Entry& entry = entries[trigger.id];
+         if (!entry.active)
+            return;
+         entry.period = sdt;
+         entry.time = multiple(t, sdt, true, EPS);
+         ++entry.version;
+         push(trigger.id);
+      }
+
+      /** Move an event (or register a new one if the trigger is unset) to a new time, it fires once. */
+      Trigger reschedule(const Trigger& trigger, const double t_event)
+      {
+         if (!trigger.valid())
+            return event(t_event);
+
+         Entry& entry = entries[trigger.id];
+         entry.period = 0.0;
+         entry.time = t_event;
+         entry.active = true;
+         ++entry.version;
+         push(trigger.id);
+         return trigger;
+      }
+
+      void remove(const size_t id)
+      {
+         entries[id].active = false;
+         entries[id].fired = false;
+         ++entries[id].version;
+      }
+
+      bool empty() const { return heap.empty(); }
+
+      /** Flag the registrations that are due at time t, and reschedule sample rates. Registrations that were passed (i.e. after a restore) are
+      * rescheduled or dropped without firing.
+      * @return Returns the time of the next sample or event, after t.
+      */
+      double fire(const double t, const double EPS)
+      {
+         while (!heap.empty() && heap.top().time < t + EPS)
+         {
+            const Queued q = heap.top();
+            heap.pop();
+
+            Entry& entry = entries[q.id];
+            if (q.version != entry.version)
+               continue; // removed or changed
+
+            if (entry.time > t - EPS)
+            {
+               entry.fired = true;
+               fired.push_back(q.id);
+            }
+
+            if (entry.period > 0.0)
+            {
+               entry.time = multiple(t, entry.period, true, EPS);
+               push(q.id);
+            }
+            else
+               entry.active = false;
+         }
+
+         while (!heap.empty() && heap.top().version != entries[heap.top().id].version)
+            heap.pop(); // so that a removed or changed registration doesn't shorten the next step
+
+         return heap.empty() ? std::numeric_limits<double>::infinity() : heap.top().time;
+      }
+
+      /** Save the registrations' rates and next times (for checkpoints and snapshots). */
+      void save(std::ostream& stream) const
+      {
+         Binary::write(stream, static_cast<uint64_t>(entries.size()));
+         for (const Entry& entry : entries)
+            Binary::write(stream, entry.period, entry.time, entry.active);
+      }
+
+      /** Restore registrations saved by save(), into a scheduler whose registrations were made by the same code (in the same order).
+      * Registrations made after the save (i.e. lazily created wake timers) are deactivated, and missing ones are added.
+      */
+      bool load(std::istream& stream)
+      {
+         uint64_t n{};
+         if (!Binary::read(stream, n))
+            return false;
+
+         clear();
+         heap = decltype(heap)();
+         if (entries.size() < n)
+            entries.resize(n);
+         for (size_t id = 0; id < entries.size(); ++id)
+         {
+            Entry& entry = entries[id];
+            ++entry.version;
+            if (id >= n)
+            {
+               entry.active = false;
+               continue;
+            }
+            if (!Binary::read(stream, entry.period, entry.time, entry.active))
+               return false;
+            if (entry.active)
+               push(id);
+         }
+         return true;
+      }
+
+      Trigger trigger(const size_t id) const { return Trigger(&entries[id].fired, id); } // the trigger of an existing registration
+
+      const std::vector<size_t>& due() const { return fired; } // ids of the registrations that fired since the last clear()
+
+      /** Lower the flags of the registrations that fired. */
+      void clear()
+      {
+         for (size_t id : fired)
+            entries[id].fired = false;
+         fired.clear();
+      }
+
+   private:
+      struct Entry
+      {
+         double period{}; // zero for events
+         double time{}; // next sample or event time
+         size_t version{};
+         bool active = true;
+         bool fired = false;
+      };
+
+      struct Queued
+      {
+         double time;
+         size_t id;
+         size_t version;
+
+         bool operator>(const Queued& rhs) const { return time > rhs.time || (time == rhs.time && id > rhs.id); }
+      };
+
+      void push(const size_t id) { heap.push(Queued{ entries[id].time, id, entries[id].version }); }
+
+      // The first multiple of period at or after t (or strictly after t), counted in ticks with an exact time base.
+      double multiple(const double t, const double period, const bool after, const double EPS) const
+      {
+         if (resolution > 0.0)
+         {
+            const int64_t T = std::llround(t / resolution);
+            const int64_t P = std::max<int64_t>(std::llround(period / resolution), 1);
+            const int64_t n = after ? T / P + 1 : (T + P - 1) / P;
+            return static_cast<double>(n * P) * resolution;
+         }
+
+         if (after)
+            return std::floor((t + EPS) / period + 1) * period;
+         return std::ceil((t - EPS) / period) * period;
+      }
+
+      std::deque<Entry> entries; // a deque, so that triggers' flags don't move
+      std::priority_queue<Queued, std::vector<Queued>, std::greater<Queued>> heap;
+      std::vector<size_t> fired;
+   };
+}
\ No newline at end of file
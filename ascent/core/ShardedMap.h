@@ -0,0 +1,80 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// A map split into independently locked shards, for registries that are shared by all simulators.
+// Threads building or destroying modules of different simulators rarely lock the same shard, so they don't serialize each other.
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+
+namespace asc
+{
+   template <typename Key, typename Value, size_t Shards = 64>
+   class ShardedMap
+   {
+   public:
+      void set(const Key& key, const Value& value)
+      {
+         Shard& s = shard(key);
+         std::lock_guard<std::mutex> lock(s.mutex);
+         s.map[key] = value;
+      }
+
+      /** Insert unless the key exists, as one operation. @return Returns false if the key already existed. */
+      bool insert(const Key& key, const Value& value)
+      {
+         Shard& s = shard(key);
+         std::lock_guard<std::mutex> lock(s.mutex);
+         return s.map.emplace(key, value).second;
+      }
+
+      void erase(const Key& key)
+      {
+         Shard& s = shard(key);
+         std::lock_guard<std::mutex> lock(s.mutex);
+         s.map.erase(key);
+      }
+
+      size_t count(const Key& key)
+      {
+         Shard& s = shard(key);
+         std::lock_guard<std::mutex> lock(s.mutex);
+         return s.map.count(key);
+      }
+
+      Value get(const Key& key) // returns a default constructed value if the key doesn't exist
+      {
+         Shard& s = shard(key);
+         std::lock_guard<std::mutex> lock(s.mutex);
+         auto it = s.map.find(key);
+         return it == s.map.end() ? Value() : it->second;
+      }
+
+   private:
+      struct Shard
+      {
+         std::mutex mutex;
+         std::map<Key, Value> map;
+      };
+
+      std::array<Shard, Shards> shards;
+
+      Shard& shard(const Key& key) { return shards[std::hash<Key>()(key) % Shards]; }
+   };
+}
\ No newline at end of file
@@ -17,13 +17,22 @@
 #include "ascent/core/DynamicMap.h"
 #include "ascent/io/ChaiEngine.h"
 
+#include "ascent/core/IntegratorGroup.h"
+#include "ascent/core/Scheduler.h"
 #include "ascent/core/State.h"
+#include "ascent/core/StepAdvisor.h"
 #include "ascent/core/Stepper.h"
 #include "ascent/core/Stopper.h"
 
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <map>
+#include <limits>
 #include <string>
+#include <typeinfo>
 
 namespace asc
 {
@@ -42,6 +51,18 @@ namespace asc
       tracker
    };
 
+   struct SkipRate // postcalc() and report() calls skipped by input change detection (see Module::input())
+   {
+      std::string module; // module name
+      size_t postcalc_checks{};
+      size_t postcalc_skips{};
+      size_t report_checks{};
+      size_t report_skips{};
+
+      double postcalcRate() const { return postcalc_checks ? static_cast<double>(postcalc_skips) / postcalc_checks : 0.0; }
+      double reportRate() const { return report_checks ? static_cast<double>(report_skips) / report_checks : 0.0; }
+   };
+
    class Simulator
    {
       typedef DynamicMap<size_t, Module*> module_map;
@@ -57,12 +78,92 @@ namespace asc
       std::vector<double> t_hist; // time history (used to interpolate and provide time pairing with Parameter history)
 
       bool run(const double dt, const double tend);
-      bool run() { return run(dt, tend); }
+      bool run() { return run(dt, tend); }
+
+      /** Incremental stepping for hosts that drive the simulation (i.e. one frame at a time): begin() once, step() or advanceTo() per frame, then end().
+      * Setup and init() run only in begin(), so each step() and advanceTo() call does only integration work. The first report() is made once,
+      * with the first step, and the last report() sees ticklast only if tend or a stopper is reached, in which case stepping stops.
+      */
+      bool begin(const double dt, const double tend = std::numeric_limits<double>::infinity());
+      bool step(const size_t n = 1); // advance n full time steps
+      bool advanceTo(const double t_target); // advance full time steps until t_target, shortening the last step to land on it
+      bool end(); // finish the run started by begin(), creating the end of simulation run files
+      bool stepping = false; // true between begin() and end()
+
+      std::vector<StepAdvice> advise(const double dt, const double tolerance, const bool apply = false); // see StepAdvisor, apply changes the time step of the next run() call
+      bool probing = false; // true while the StepAdvisor evaluates update() passes, sample() returns false while probing
+
+      std::vector<double> captureStates(); // values of all states, ordered by module creation and then by addIntegrator() calls
+      bool seedStates(const std::vector<double>& x, const double t); // sets all states (ordered as captureStates()) and the time, initializes modules first and restarts the integrator
+      void clearHistories(); // clears the time history and the histories of all module variables, i.e. before reusing a simulator for another trajectory
+
+      // Binary checkpoints of the clock, states and their integration history, module variables (with histories), and Module::checkpoint() data.
+      // A checkpoint is restored into a simulator whose modules were built by the same code (in the same order), after which run() continues.
+      // Modules that were initialized when the checkpoint was written aren't initialized again.
+      // Without histories, the time and variable histories aren't written, so the checkpoint's size doesn't grow with the run. Such a checkpoint can
+      // only roll back the simulator that wrote it (i.e. for Time Warp), histories are rewound by dropping the values recorded since the checkpoint.
+      bool checkpoint(std::ostream& stream, const bool histories = true);
+      bool restore(std::istream& stream);
+      bool checkpoint(const std::string& file);
+      bool restore(const std::string& file);
+
+      /** Write a checkpoint every interval of simulation time during run(), the file is written asynchronously.
+      * A checkpoint is skipped if the previous one is still being written, which bounds the overhead. A non-positive interval turns checkpointing off.
+      */
+      void checkpointEvery(const double interval, const std::string& file);
+      size_t checkpoints_written = 0;
+      size_t checkpoints_skipped = 0;
+
+      /** Fork this simulator into branches on new simulators, which continue independently (i.e. on separate threads) from the current state.
+      * Each branch is built by the factory and then restored from an in-memory checkpoint of this simulator, so it gets the same
+      * integrator, states, integrator internals, variables, and histories. Histories are copied to every branch. Call between run() calls.
+      * @param factory  Builds the model in the given simulator, as this simulator's model was built. Returns a module that owns (i.e. via Links) the rest of the model.
+      * @param sims  Simulator numbers for the branches, which must not have states yet.
+      * @return Returns the branches' modules returned by the factory, empty if forking failed.
+      */
+      std::vector<Link<Module>> fork(const std::function<Link<Module>(const size_t sim)>& factory, const std::vector<size_t>& sims);
+
+      std::function<std::unique_ptr<State>(Stepper& stepper)> make_integrator; // constructs this simulator's type of integrator, used for forking
+
+      /** Capture this simulator in memory, initializing its modules first if needed (i.e. after expensive init() computations).
+      * restoreSnapshot() then resets the simulator in place, reusing its modules and their memory, for fast repeated runs (i.e. Monte Carlo).
+      * Captures the clock, states and integrator internals, variables registered via define() (ascVar) with their histories, and Module::checkpoint() data.
+      */
+      bool snapshot();
+      bool restoreSnapshot(); // fails if modules were created or deleted since the snapshot
 
       bool sample();
       bool sample(double sdt);
       bool event(double t_event);
 
+      Scheduler scheduler; // sample rates and events registered by modules, evaluated once per time step
+      double fire(); // flag the sample rates and events that are due at the current time and collect due discrete modules, returns the next scheduled time
+
+      std::map<size_t, Module*> discretes; // discrete modules (see Module::discrete()) by their scheduler registration id
+      std::vector<Module*> due; // discrete modules whose sample time is the current time
+      std::vector<Module*> discrete_resets; // discrete modules that updated in this pass, reset at the end of the pass
+
+      // Sleeping modules (see Module::sleep()) are removed from every phase and from state propagation, at full time step boundaries.
+      std::vector<Module*> to_sleep; // modules that fall asleep at the end of the current full time step
+      std::vector<Module*> to_wake; // modules that wake at the start of the next full time step
+      std::multimap<size_t, Module*> wakers; // sleeping modules that wake when a scheduler registration fires, by registration id
+      /** Jump over quiescent intervals: when no module has update(), postcalc(), check(), report() or reset() work (i.e. all are asleep or discrete
+      * and not due) and no state can change (frozen, or zero derivatives), a full time step spans to the next scheduled sample rate or event, tend,
+      * the advanceTo() target or the next periodic checkpoint. Tracking then records a single step for the interval.
+      */
+      bool jump_quiescent = false;
+      size_t quiescent_jumps = 0;
+      bool quiescent(); // no phase work and no state changes over the next full time step
+      void jump(const double t_next);
+
+      void sleepModules();
+      void wakeModules();
+      void sleepNow(Module* module);
+      void wakeNow(Module* module);
+      void restoreSleep(Module& module, const bool sleeping, const bool sleep_pending, const bool wake_pending, const uint64_t wake_timer, const uint64_t wake_on); // checkpoints and snapshots
+      void saveFlags(std::ostream& stream, const Module& module) const; // run flags of a module (freezing, stop, fidelity, and sleep), for checkpoints and snapshots
+      bool loadFlags(std::istream& stream, Module& module);
+
       bool error = false;
       std::vector<std::string> error_descriptions;
       bool print_errors = true;
@@ -72,6 +173,7 @@ namespace asc
       const size_t sim;
 
       void directErase(bool b);
+      void reserve(const size_t steps); // reserve memory for steps more full time steps (time history, postponed erases and deletes), so that they don't reallocate
 
       module_map modules;
 
@@ -102,6 +204,9 @@ namespace asc
 
       void propagateStates(); // calls Module propagateStates() methods
       void updateClock();
+      void holdGroups(); // interpolates the states of groups that completed their step before the simulator's integrator, see IntegratorGroup
+      void groupStates(IntegratorGroup& group, std::vector<double>& x);
+      void seedGroup(IntegratorGroup& group, const std::vector<double>& x);
 
       bool time_advanced = false; // Whether or not time advanced with the last simulation pass.
 
@@ -115,6 +220,28 @@ namespace asc
       std::unique_ptr<State> integrator;
       Stepper stepper;
 
+      std::vector<std::unique_ptr<IntegratorGroup>> groups; // integrators selected per module, group ids start at 1 (0 is the simulator's integrator)
+
+      /** Get the group id for states integrated with integrator type T, creating the group if needed.
+      * @return Returns 0 if T is the simulator's integrator.
+      */
+      template <typename T>
+      size_t integratorGroup()
+      {
+         if (typeid(T) == typeid(*integrator))
+            return 0;
+
+         for (auto& group : groups)
+         {
+            if (group->type == typeid(T))
+               return group->id;
+         }
+
+         groups.emplace_back(new IntegratorGroup(groups.size() + 1, typeid(T), EPS, dtp, dt));
+         groups.back()->integrator = std::make_unique<T>(groups.back()->stepper);
+         return groups.back()->id;
+      }
+
       bool tick0 = true; // Very first tick of the simulation, used to avoid overlapping between tickfirst and ticklast tracking calls for additional run() calls.
 
       double EPS = 1e-8;
@@ -129,11 +256,36 @@ namespace asc
       double tend{}; // end time of this simulation loop
       size_t kpass{};
 
+      /** Exact time base: with a positive resolution, time is counted in int64 ticks of resolution seconds. Full time steps, sample(), event() and the
+      * scheduler work on ticks, so steps land exactly on multiples of the time step without floor() and EPS drift over long runs, and t (for module
+      * code) is derived from the ticks at every full time step. Time steps, sampling rates, and event times are rounded to ticks.
+      */
+      void timeBase(const double resolution);
+      double resolution = 0.0; // seconds per tick, 0 for floating point time
+      int64_t tick{}; // time in ticks, at the start of the current full time step
+      int64_t tick1{}; // intended end of the current full time step in ticks
+      int64_t dtp_ticks{}; // base time step in ticks
+      int64_t ticks(const double time) const { return std::llround(time / resolution); }
+      uint64_t step_index{}; // index of the current time step (0 before the first step, i.e. during init()), counters of the modules' random streams
+
+      uint64_t random_seed{}; // base seed of the modules' random streams (see Module::random())
+      uint64_t random_key; // identifies this simulator's random streams, the simulator number by default (set per run for ensembles, since workers reuse simulators)
+      size_t modules_created{}; // number of modules created in this simulator, which identifies modules deterministically (unlike module ids, which are global)
+
       bool integrator_initialized = false; // whether or not the integration scheme has been initialized (i.e. for a predictor-corrector or DOPRI45), not used for basic schemes like RK4
 
       void integrationTolerance(double tolerance); // Set adaptive step size tolerance for all modules in this simulator.
 
-      static std::map<std::string, std::shared_ptr<Module>> tracking; // all trackers for all simulators
+      // Fidelity tiers (see Module::addFidelity()), call between full time steps. demote() lowers the tier of the module with the lowest fidelity
+      // priority that has a lower tier left (the latest created on ties), and promote() reverses the latest demotion.
+      // Both return the changed module, or nullptr if no module could be changed.
+      Module* demote();
+      Module* promote();
+
+      std::vector<SkipRate> skipRates(); // for modules with declared inputs (see Module::input())
+      std::vector<size_t> demoted; // ids of demoted modules in demotion order, once per tier
+
+      std::map<std::string, std::shared_ptr<Module>> tracking; // trackers of this simulator (per simulator, so that simulators can run on separate threads)
 
       void addStopper(std::shared_ptr<Module>& module)
       {
@@ -160,5 +312,21 @@ namespace asc
 
       void runStoppers();
       std::vector<std::shared_ptr<Stopper>> stoppers;
+
+   private:
+      double horizon = std::numeric_limits<double>::infinity(); // advanceTo() target
+
+      double checkpoint_interval{};
+      double checkpoint_next{};
+      std::string checkpoint_file;
+      std::future<bool> checkpoint_write; // pending asynchronous checkpoint write
+
+      void periodicCheckpoint();
+
+      bool pass(); // a single integration pass (one update() call), returns true if it completed a full time step
+      bool finish(); // common end of run() and end()
+
+      std::vector<size_t> snapshot_modules; // module ids at the time of the snapshot
+      std::vector<std::function<void()>> snapshot_restores;
    };
 }
\ No newline at end of file
@@ -14,15 +14,27 @@
 
 #pragma once
 
+#include "Lanes.h"
+
+#include <iosfwd>
+#include <vector>
+
+// State is the scalar independent interface to an integrated state. Integrators are templated on the state's scalar type (see StateStepper).
+
 namespace asc
 {
    class State
    {
    public:
-      State(double &x, double &xd) : x(x), xd(xd) {}
+      State() {}
       virtual ~State() {}
 
+      // An integrator creates states of its integration scheme for every supported scalar type, so simulators can mix precisions.
+      virtual State* factory(float &x, float &xd) = 0;
       virtual State* factory(double &x, double &xd) = 0;
+      virtual State* factory(long double &x, long double &xd) = 0;
+      virtual State* factory(Lanes &/*x*/, Lanes &/*xd*/) { return nullptr; } // lockstep ensemble lanes, only supported by fixed step integrators
+      virtual State* bind(State& integrator) = 0; // creates a state of another integrator for this state's variables
 
       virtual void propagate() = 0;
       virtual void updateClock() = 0;
@@ -30,7 +42,21 @@ namespace asc
       virtual bool adaptive() { return false; } // Whether this is an adaptive integrator (NOT FSAL), like Dormand Prince 87 (DOPRI87).
       virtual bool adaptiveFSAL() { return false; } // Whether this is a First Same As Last (FSAL) adaptive integration scheme (i.e. Dormand Prince 45 (DOPRI45)).
 
-      double &x, &xd; // xd is the derivative of x
+      virtual double value() const = 0; // the state, converted to double
+      virtual void value(const double v) = 0; // set the state from a double
+      virtual double derivative() const = 0; // the state derivative, converted to double
+      virtual size_t width() const { return 1; } // number of scalar values of the state (i.e. its lanes)
+      virtual void capture(std::vector<double>& values) const { values.push_back(value()); } // appends all width() values of the state
+      virtual void seed(const double* values) { value(*values); } // sets the state from width() values
+      virtual bool still() const { return false; } // whether the state can't change over the next step if its derivative isn't updated (see Simulator::quiescent())
+
+      // Checkpoints: save() and load() handle the state and its integration history. The integrator methods are called on the prototype integrator,
+      // for data that is shared by all of its states (i.e. initialization progress).
+      virtual void save(std::ostream& stream) const = 0;
+      virtual bool load(std::istream& stream) = 0;
+      virtual void saveIntegrator(std::ostream& /*stream*/) const {}
+      virtual bool loadIntegrator(std::istream& /*stream*/) { return true; }
+
       double tolerance; // allows adaptive step size tolerance to be set uniquely for every state
    };
 }
\ No newline at end of file
@@ -14,20 +14,55 @@
 
 #pragma once
 
+#include "Binary.h"
 #include "State.h"
 #include "Stepper.h"
 
 #include <math.h>
 
+// Members of the dependent base class StateStepper<T> aren't found by unqualified name lookup in templated integrators, so integrators declare them with this macro.
+#define ascStateStepper(T) using StateStepper<T>::x; using StateStepper<T>::xd; using StateStepper<T>::x0; using StateStepper<T>::tolerance; \
+using StateStepper<T>::EPS; using StateStepper<T>::dtp; using StateStepper<T>::dt; using StateStepper<T>::t; using StateStepper<T>::t1; \
+using StateStepper<T>::kpass; using StateStepper<T>::integrator_initialized;
+
 namespace asc
 {
+   // T is the scalar type of the state (float, double, long double, or Lanes).
+   // Integration arithmetic with the time step (double) is promoted, so float states save memory and long double states keep extended precision.
+   template <typename T>
    class StateStepper : public State, public Stepper
    {
    public:
-      StateStepper(double &x, double& xd, Stepper& stepper) : State(x, xd), Stepper(stepper) {}
+      StateStepper(T &x, T &xd, Stepper& stepper) : Stepper(stepper), x(x), xd(xd) {}
 
       virtual double optimalTimeStep() { return dt; } // For adaptive step algorithms
 
-      double x0;
+      State* bind(State& integrator) { return integrator.factory(x, xd); }
+
+      double value() const { return scalar(x); }
+
+      void value(const double v) { scalar(x, v); }
+      double derivative() const { return scalar(xd); }
+      size_t width() const { return lanes(x); }
+
+      void capture(std::vector<double>& values) const
+      {
+         for (size_t i = 0; i < lanes(x); ++i)
+            values.push_back(lane(x, i));
+      }
+
+      void seed(const double* values)
+      {
+         for (size_t i = 0; i < lanes(x); ++i)
+            lane(x, i, values[i]);
+      }
+
+      bool still() const { return zero(xd); } // single step methods only use derivatives of the current step
+
+      void save(std::ostream& stream) const { Binary::write(stream, x, xd, x0, tolerance); }
+      bool load(std::istream& stream) { return Binary::read(stream, x, xd, x0, tolerance); }
+
+      T &x, &xd; // xd is the derivative of x
+      T x0;
    };
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Estimates the largest stable and accurate fixed time step for each fixed step integrator, for the current states of a simulator.
+// Stability: the dominant eigenvalue of the states' Jacobian is estimated by power iteration, using finite differences over update() passes.
+// Each integrator is then applied to the linear test equation x' = lambda*x in order to find the largest stable step.
+// Accuracy: the local truncation error is estimated by step doubling of the actual model, with temporary states of each integrator.
+// The simulator's states and clock are restored after the analysis. Module update() methods are called with sample() returning false,
+// so discrete (sampled) logic is not run, but update() must otherwise compute derivatives without side effects.
+
+#include "ascent/core/State.h"
+#include "ascent/core/Stepper.h"
+
+#include <complex>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+namespace asc
+{
+   class Simulator;
+
+   struct StepAdvice
+   {
+      std::string integrator; // integrator name
+      std::type_index type = typeid(void); // integrator type, used to match the simulator's integrator
+      double dt_stable{}; // largest stable time step (infinity if no limit was found)
+      double dt_accurate{}; // largest time step that satisfies the tolerance (infinity if no error was measured)
+
+      double dt() const { return dt_stable < dt_accurate ? dt_stable : dt_accurate; } // largest stable and accurate time step
+   };
+
+   class StepAdvisor
+   {
+   public:
+      StepAdvisor(Simulator& simulator) : simulator(simulator) {}
+
+      /** Analyze the simulator's states at the current time.
+      * @param dt  The time step used for step doubling.
+      * @param tolerance  Allowed local truncation error per step for each state, relative to (1 + |x|).
+      * @return Returns the advised time steps for every fixed step integrator.
+      */
+      std::vector<StepAdvice> advise(const double dt, const double tolerance);
+
+      std::complex<double> eigenvalue; // estimated dominant eigenvalue of the Jacobian
+      double spectral_radius{}; // estimated magnitude of the dominant eigenvalue
+
+      size_t iterations = 30; // power iterations
+      size_t doubling_steps = 4; // number of steps used for step doubling, more steps than predictor-corrector initialization steps
+
+      static void print(const std::vector<StepAdvice>& advice, std::ostream& stream = std::cout);
+
+   private:
+      Simulator& simulator;
+
+      struct Candidate
+      {
+         std::string name;
+         std::type_index type;
+         unsigned order; // global order of accuracy
+         std::function<std::unique_ptr<State>(Stepper&)> make; // constructs an integrator prototype
+      };
+
+      static std::vector<Candidate> candidates();
+
+      std::vector<State*> states; // states that are propagated
+
+      void derivatives(std::vector<double>& xd); // evaluates all state derivatives via update()
+      void estimateEigenvalue();
+      double stableStep(const Candidate& candidate) const;
+      bool stable(const Candidate& candidate, const double h) const;
+      double accurateStep(const Candidate& candidate, const double h, const double tolerance);
+      bool integrate(const Candidate& candidate, const double h, const size_t steps); // integrates the model with temporary states, false if the candidate doesn't support the states
+      std::string saveStates() const;
+      void loadStates(const std::string& saved);
+   };
+}
\ No newline at end of file
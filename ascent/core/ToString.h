@@ -28,28 +28,25 @@ namespace asc
       template <typename T>
       static std::string print(T& x)
       {
-         if (print_map.count(typeid(T)))
-            return print_map[typeid(T)](&x);
-
-         // If the type hasn't been registered, then register it:
-         registerType(x);
-
-         return print_map[typeid(T)](&x);
+         // Each type's printer is created once, by the first call for that type. Function local statics are initialized thread safely,
+         // so simulators on separate threads don't share a registry.
+         static const Printer printer = makePrinter(x);
+         return printer(&x);
       }
 
    private:
-      static std::map<std::type_index, std::function<std::string(void* x)>> print_map; // a map of to_string functions for registered types
+      using Printer = std::function<std::string(void* x)>; // to_string function for a type
 
       template <typename T>
-      static void registerType(T& value)
+      static Printer makePrinter(T& value)
       {
-         print_map[typeid(T)] = [&](void* x) { return std::to_string(*static_cast<T*>(x)); };
+         return [](void* x) { return std::to_string(*static_cast<T*>(x)); };
       }
 
       template <typename T>
-      static void registerType(std::vector<T>& value) // value isn't needed, but it is used to distinguish between registerType functions (could use std::enable_if instead)
+      static Printer makePrinter(std::vector<T>& value) // value isn't needed, but it is used to distinguish between makePrinter functions (could use std::enable_if instead)
       {
-         print_map[typeid(std::vector<T>)] = [&](void* x) {
+         return [](void* x) {
             std::vector<T>& vec = *static_cast<std::vector<T>*>(x);
 
             std::string output = "";
@@ -66,17 +63,17 @@ namespace asc
          };
       }
 
-      static void registerType(std::string& value)
+      static Printer makePrinter(std::string& value)
       {
-         print_map[typeid(std::string)] = [&](void* x) { return *static_cast<std::string*>(x); };
+         return [](void* x) { return *static_cast<std::string*>(x); };
       }
 
 
       // For Eigen vectors of any length
       template <typename T>
-      static void registerEigen()
+      static Printer eigenPrinter()
       {
-         print_map[typeid(T)] = [&](void* x) {
+         return [](void* x) {
             T matrix = *static_cast<T*>(x);
 
             std::string output = "";
@@ -94,22 +91,22 @@ namespace asc
       }
 
       template <typename T, int rows>
-      static void registerType(Eigen::Matrix<T, rows, 1, 0, rows, 1>& value)
+      static Printer makePrinter(Eigen::Matrix<T, rows, 1, 0, rows, 1>& value)
       {
-         registerEigen<Eigen::Matrix<T, rows, 1, 0, rows, 1>>();
+         return eigenPrinter<Eigen::Matrix<T, rows, 1, 0, rows, 1>>();
       }
 
       // For dynamic Eigen vectors
-      static void registerType(Eigen::VectorXd& value)
+      static Printer makePrinter(Eigen::VectorXd& value)
       {
-         registerEigen<Eigen::VectorXd>();
+         return eigenPrinter<Eigen::VectorXd>();
       }
 
-      static void registerType(Eigen::Matrix2d& value) { registerEigen<Eigen::Matrix2d>(); }
-      static void registerType(Eigen::Matrix3d& value) { registerEigen<Eigen::Matrix3d>(); }
-      static void registerType(Eigen::Matrix4d& value) { registerEigen<Eigen::Matrix4d>(); }
-      static void registerType(Eigen::Matrix<double, 6, 6>& value) { registerEigen<Eigen::Matrix<double, 6, 6>>(); }
-      static void registerType(Eigen::Matrix<double, 9, 9>& value) { registerEigen<Eigen::Matrix<double, 9, 9>>(); }
-      static void registerType(Eigen::MatrixXd& value) { registerEigen<Eigen::MatrixXd>(); }
+      static Printer makePrinter(Eigen::Matrix2d& value) { return eigenPrinter<Eigen::Matrix2d>(); }
+      static Printer makePrinter(Eigen::Matrix3d& value) { return eigenPrinter<Eigen::Matrix3d>(); }
+      static Printer makePrinter(Eigen::Matrix4d& value) { return eigenPrinter<Eigen::Matrix4d>(); }
+      static Printer makePrinter(Eigen::Matrix<double, 6, 6>& value) { return eigenPrinter<Eigen::Matrix<double, 6, 6>>(); }
+      static Printer makePrinter(Eigen::Matrix<double, 9, 9>& value) { return eigenPrinter<Eigen::Matrix<double, 9, 9>>(); }
+      static Printer makePrinter(Eigen::MatrixXd& value) { return eigenPrinter<Eigen::MatrixXd>(); }
    };
 }
\ No newline at end of file
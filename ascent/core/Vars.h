@@ -18,9 +18,11 @@
 // Anyar Inc
 // Stephen Berry
 
+#include "Binary.h"
 #include "Parameter.h"
 #include "ToString.h"
 
+#include <algorithm>
 #include <iostream>
 #include <functional>
 #include <map>
@@ -49,6 +51,29 @@ namespace asc
       std::map<std::string, std::function<size_t()>> t_begin_map;
       std::map<std::string, std::function<void(size_t steps)>> steps_map;
       std::map<std::string, std::function<void(bool infinite)>> steps_infinite_map;
+      std::map<std::string, std::function<void()>> clear_map;
+      std::map<std::string, std::function<bool(std::ostream& stream)>> save_map;
+      std::map<std::string, std::function<bool(std::istream& stream)>> load_map;
+      std::map<std::string, std::function<std::function<void()>()>> snapshot_map;
+      std::map<std::string, std::function<bool(std::ostream& stream)>> mark_map;
+      std::map<std::string, std::function<bool(std::istream& stream, const size_t dropped)>> rewind_map;
+
+      // Returns a closure that restores the value and history captured now, assignment reuses the variable's memory.
+      template <typename T>
+      static typename std::enable_if<std::is_copy_assignable<T>::value, std::function<void()>>::type snapshot(Parameter<T>& ref)
+      {
+         return [&ref, value = *ref.ptr, x = ref.x, t_begin = ref.t_begin, steps = ref.steps, infinite = ref.infinite]()
+         {
+            *ref.ptr = value;
+            ref.x = x;
+            ref.t_begin = t_begin;
+            ref.steps = steps;
+            ref.infinite = infinite;
+         };
+      }
+
+      template <typename T>
+      static typename std::enable_if<!std::is_copy_assignable<T>::value, std::function<void()>>::type snapshot(Parameter<T>& ref) { return []() {}; }
 
       template <typename T>
       std::map<std::string, Parameter<T>>& getMap()
@@ -110,6 +135,21 @@ namespace asc
 
          type_map[id] = [&]() -> std::string { return ref.type(); };
 
+         // The value and its history are saved for checkpoints, returns false for types that Binary doesn't support.
+         save_map[id] = [&](std::ostream& stream) { return Binary::write(stream, *ref.ptr, ref.x, ref.t_begin, ref.steps, ref.infinite); };
+         load_map[id] = [&](std::istream& stream) { return Binary::read(stream, *ref.ptr, ref.x, ref.t_begin, ref.steps, ref.infinite); };
+         snapshot_map[id] = [&]() { return snapshot(ref); };
+
+         // Checkpoints without histories (rollbacks) only save the value, histories are rewound by dropping the values recorded since the checkpoint.
+         mark_map[id] = [&](std::ostream& stream) { return Binary::write(stream, *ref.ptr, ref.t_begin, ref.steps, ref.infinite); };
+         rewind_map[id] = [&](std::istream& stream, const size_t dropped)
+         {
+            if (!Binary::read(stream, *ref.ptr, ref.t_begin, ref.steps, ref.infinite))
+               return false;
+            ref.x.erase(ref.x.end() - static_cast<std::ptrdiff_t>(std::min(dropped, ref.x.size())), ref.x.end());
+            return true;
+         };
+
          return ref;
       }
 
@@ -125,6 +165,7 @@ namespace asc
          t_begin_map[id] = [&]() -> size_t { return ref.t_begin; };
          steps_map[id] = [&](size_t steps) { ref.steps = steps; };
          steps_infinite_map[id] = [&](bool inifinite) { ref.infinite = inifinite; };
+         clear_map[id] = [&]() { ref.x.clear(); ref.t_begin = 0; };
 
          print_map[id] = [&](const size_t i) -> std::string { return ToString::print(ref.x[i]); };
       }
@@ -151,6 +192,12 @@ namespace asc
             p.second();
       }
 
+      void clearHistories() // clears the histories of all tracked parameters
+      {
+         for (auto& p : clear_map)
+            p.second();
+      }
+
       std::string print(const std::string& id)
       {
          size_t n = length(id) - 1; // get last element
@@ -189,6 +236,46 @@ namespace asc
          return 0;
       }
 
+      bool save(const std::string& id, std::ostream& stream)
+      {
+         if (save_map.count(id))
+            return save_map[id](stream);
+         simulator.setError("Access failure in Vars::save(" + id + ")");
+         return false;
+      }
+
+      bool load(const std::string& id, std::istream& stream)
+      {
+         if (load_map.count(id))
+            return load_map[id](stream);
+         simulator.setError("Access failure in Vars::load(" + id + ")");
+         return false;
+      }
+
+      bool mark(const std::string& id, std::ostream& stream) // saves the value but not the history
+      {
+         if (mark_map.count(id))
+            return mark_map[id](stream);
+         simulator.setError("Access failure in Vars::mark(" + id + ")");
+         return false;
+      }
+
+      bool rewind(const std::string& id, std::istream& stream, const size_t dropped) // restores the value of mark() and drops the last values of the history
+      {
+         if (rewind_map.count(id))
+            return rewind_map[id](stream, dropped);
+         simulator.setError("Access failure in Vars::rewind(" + id + ")");
+         return false;
+      }
+
+      std::function<void()> snapshot(const std::string& id) // captures the variable, the returned closure restores it
+      {
+         if (snapshot_map.count(id))
+            return snapshot_map[id]();
+         simulator.setError("Access failure in Vars::snapshot(" + id + ")");
+         return []() {};
+      }
+
       template <typename T>
       bool set(const std::string& id, const T& x)
       {
@@ -20,20 +20,32 @@
 
 namespace asc
 {
-   class DOPRI45 : public StateStepper
+   template <typename T>
+   class DOPRI45T : public StateStepper<T>
    {
    public:
-      DOPRI45(Stepper &stepper) : StateStepper(x, xd, stepper) {}
-      DOPRI45(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper) {}
+      ascStateStepper(T)
 
-      DOPRI45* factory(double &x, double &xd) { return new DOPRI45(x, xd, static_cast<Stepper&>(*this)); }
+      DOPRI45T(Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+      DOPRI45T(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+
+      DOPRI45T<float>* factory(float &x, float &xd) { return new DOPRI45T<float>(x, xd, static_cast<Stepper&>(*this)); }
+      DOPRI45T<double>* factory(double &x, double &xd) { return new DOPRI45T<double>(x, xd, static_cast<Stepper&>(*this)); }
+      DOPRI45T<long double>* factory(long double &x, long double &xd) { return new DOPRI45T<long double>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
       double optimalTimeStep();
       bool adaptiveFSAL() { return true; }
 
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); Binary::write(stream, xd0, xd1, xd2, xd3, xd4, xd5); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && Binary::read(stream, xd0, xd1, xd2, xd3, xd4, xd5); }
+      void saveIntegrator(std::ostream& stream) const { Binary::write(stream, t0); }
+      bool loadIntegrator(std::istream& stream) { return Binary::read(stream, t0); }
+
       double t0;
-      double xd0, xd1, xd2, xd3, xd4, xd5;
+      T xd0, xd1, xd2, xd3, xd4, xd5;
    };
+
+   using DOPRI45 = DOPRI45T<double>;
 }
\ No newline at end of file
@@ -20,20 +20,32 @@
 
 namespace asc
 {
-   class DOPRI87 : public StateStepper
+   template <typename T>
+   class DOPRI87T : public StateStepper<T>
    {
    public:
-      DOPRI87(Stepper &stepper) : StateStepper(x, xd, stepper) {}
-      DOPRI87(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper) {}
+      ascStateStepper(T)
 
-      DOPRI87* factory(double &x, double &xd) { return new DOPRI87(x, xd, static_cast<Stepper&>(*this)); }
+      DOPRI87T(Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+      DOPRI87T(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+
+      DOPRI87T<float>* factory(float &x, float &xd) { return new DOPRI87T<float>(x, xd, static_cast<Stepper&>(*this)); }
+      DOPRI87T<double>* factory(double &x, double &xd) { return new DOPRI87T<double>(x, xd, static_cast<Stepper&>(*this)); }
+      DOPRI87T<long double>* factory(long double &x, long double &xd) { return new DOPRI87T<long double>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
       double optimalTimeStep();
       bool adaptive() { return true; }
 
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); Binary::write(stream, xd0, xd1, xd2, xd3, xd4, xd5, xd6, xd7, xd8, xd9, xd10, xd11); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && Binary::read(stream, xd0, xd1, xd2, xd3, xd4, xd5, xd6, xd7, xd8, xd9, xd10, xd11); }
+      void saveIntegrator(std::ostream& stream) const { Binary::write(stream, t0); }
+      bool loadIntegrator(std::istream& stream) { return Binary::read(stream, t0); }
+
       double t0;
-      double xd0, xd1, xd2, xd3, xd4, xd5, xd6, xd7, xd8, xd9, xd10, xd11;
+      T xd0, xd1, xd2, xd3, xd4, xd5, xd6, xd7, xd8, xd9, xd10, xd11;
    };
+
+   using DOPRI87 = DOPRI87T<double>;
 }
\ No newline at end of file
@@ -20,15 +20,23 @@
 
 namespace asc
 {
-   class Euler : public StateStepper
+   template <typename T>
+   class EulerT : public StateStepper<T>
    {
    public:
-      Euler(Stepper &stepper) : StateStepper(x, xd, stepper) {}
-      Euler(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper) {}
+      ascStateStepper(T)
 
-      Euler* factory(double &x, double &xd) { return new Euler(x, xd, static_cast<Stepper&>(*this)); }
+      EulerT(Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+      EulerT(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+
+      EulerT<float>* factory(float &x, float &xd) { return new EulerT<float>(x, xd, static_cast<Stepper&>(*this)); }
+      EulerT<double>* factory(double &x, double &xd) { return new EulerT<double>(x, xd, static_cast<Stepper&>(*this)); }
+      EulerT<long double>* factory(long double &x, long double &xd) { return new EulerT<long double>(x, xd, static_cast<Stepper&>(*this)); }
+      EulerT<Lanes>* factory(Lanes &x, Lanes &xd) { return new EulerT<Lanes>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
    };
+
+   using Euler = EulerT<double>;
 }
\ No newline at end of file
@@ -0,0 +1,94 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Gragg-Bulirsch-Stoer extrapolation integrator with adaptive order and step size.
+// Each full step runs the modified midpoint rule for the step sequence n = 2, 4, 6, 8, ... (one update() pass per substep)
+// and extrapolates the results to zero step size (Aitken-Neville). The number of extrapolation columns (order 2*columns)
+// and the time step are adapted when states have a positive tolerance.
+// Source: E. Hairer, S.P. Norsett, G. Wanner. Solving Ordinary Differential Equations I. Section II.9.
+
+#include "ascent/core/StateStepper.h"
+
+#include <memory>
+#include <vector>
+
+namespace asc
+{
+   // Step sequence and order control, shared by all states of a simulator because every state must run the same number of passes.
+   struct GBSControl
+   {
+      GBSControl() { build(); }
+
+      size_t columns = 4; // current number of extrapolation columns (order 2*columns)
+      size_t min_columns = 2; // at least two columns are required for an error estimate
+      size_t max_columns = 8;
+
+      size_t previous_columns = 4; // columns used for the step that just completed
+      bool reported = false; // whether any state reported an error estimate this step
+      std::vector<double> err; // largest scaled error of each column across all states for the current step
+
+      std::vector<size_t> sequence; // sequence index for each pass
+      std::vector<size_t> substep; // substep index (1 to n) whose derivative is computed at each pass
+
+      size_t n(const size_t j) const { return 2 * (j + 1); } // number of midpoint substeps for sequence j
+      size_t work(const size_t j) const; // number of update() passes needed to complete sequence j
+      size_t passes() const { return sequence.size(); }
+
+      void build(); // rebuild the pass tables for the current number of columns
+      void selectOrder(); // choose the number of columns for the next step from the reported errors
+   };
+
+   template <typename T>
+   class GBST : public StateStepper<T>
+   {
+   public:
+      ascStateStepper(T)
+
+      GBST(Stepper &stepper) : StateStepper<T>(x, xd, stepper), control(std::make_shared<GBSControl>()) {}
+      GBST(T &x, T &xd, Stepper &stepper, std::shared_ptr<GBSControl>& control) : StateStepper<T>(x, xd, stepper), control(control),
+         row(control->max_columns), err(control->max_columns) {}
+
+      GBST<float>* factory(float &x, float &xd) { return new GBST<float>(x, xd, static_cast<Stepper&>(*this), control); }
+      GBST<double>* factory(double &x, double &xd) { return new GBST<double>(x, xd, static_cast<Stepper&>(*this), control); }
+      GBST<long double>* factory(long double &x, long double &xd) { return new GBST<long double>(x, xd, static_cast<Stepper&>(*this), control); }
+
+      void propagate();
+      void updateClock();
+      double optimalTimeStep();
+      bool adaptive() { return true; }
+
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); Binary::write(stream, xd0, z_1, row, err); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && Binary::read(stream, xd0, z_1, row, err); }
+      void saveIntegrator(std::ostream& stream) const { Binary::write(stream, t0, control->columns, control->previous_columns); }
+      bool loadIntegrator(std::istream& stream)
+      {
+         if (!Binary::read(stream, t0, control->columns, control->previous_columns))
+            return false;
+         control->build();
+         return true;
+      }
+
+      std::shared_ptr<GBSControl> control;
+
+      double t0;
+      T xd0;
+      T z_1; // -1, previous midpoint value
+      std::vector<T> row; // latest row of the extrapolation tableau
+      std::vector<double> err; // scaled error estimate of each column for this state
+   };
+
+   using GBS = GBST<double>;
+}
\ No newline at end of file
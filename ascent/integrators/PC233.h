@@ -25,19 +25,31 @@
 
 namespace asc
 {
-   class PC233 : public StateStepper
+   template <typename T>
+   class PC233T : public StateStepper<T>
    {
    public:
-      PC233(Stepper &stepper) : StateStepper(x, xd, stepper), initializer(new RK4(stepper)) {}
-      PC233(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper), initializer(new RK4(x, xd, stepper)) {}
+      ascStateStepper(T)
 
-      PC233* factory(double &x, double &xd) { return new PC233(x, xd, static_cast<Stepper&>(*this)); }
+      PC233T(Stepper &stepper) : StateStepper<T>(x, xd, stepper), initializer(new RK4T<T>(stepper)) {}
+      PC233T(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper), initializer(new RK4T<T>(x, xd, stepper)) {}
+
+      PC233T<float>* factory(float &x, float &xd) { return new PC233T<float>(x, xd, static_cast<Stepper&>(*this)); }
+      PC233T<double>* factory(double &x, double &xd) { return new PC233T<double>(x, xd, static_cast<Stepper&>(*this)); }
+      PC233T<long double>* factory(long double &x, long double &xd) { return new PC233T<long double>(x, xd, static_cast<Stepper&>(*this)); }
+      PC233T<Lanes>* factory(Lanes &x, Lanes &xd) { return new PC233T<Lanes>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
 
-      std::unique_ptr<RK4> initializer;
-      double xd0;
-      double xd_1; // -1, previous time step derivative
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); initializer->save(stream); Binary::write(stream, xd0, xd_1); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && initializer->load(stream) && Binary::read(stream, xd0, xd_1); }
+      bool still() const { return integrator_initialized && zero(xd) && zero(xd_1); } // and the derivative history
+
+      std::unique_ptr<RK4T<T>> initializer;
+      T xd0;
+      T xd_1; // -1, previous time step derivative
    };
+
+   using PC233 = PC233T<double>;
 }
\ No newline at end of file
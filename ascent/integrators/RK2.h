@@ -20,17 +20,28 @@
 
 namespace asc
 {
-   class RK2 : public StateStepper
+   template <typename T>
+   class RK2T : public StateStepper<T>
    {
    public:
-      RK2(Stepper &stepper) : StateStepper(x, xd, stepper) {}
-      RK2(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper) {}
+      ascStateStepper(T)
 
-      RK2* factory(double &x, double &xd) { return new RK2(x, xd, static_cast<Stepper&>(*this)); }
+      RK2T(Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+      RK2T(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+
+      RK2T<float>* factory(float &x, float &xd) { return new RK2T<float>(x, xd, static_cast<Stepper&>(*this)); }
+      RK2T<double>* factory(double &x, double &xd) { return new RK2T<double>(x, xd, static_cast<Stepper&>(*this)); }
+      RK2T<long double>* factory(long double &x, long double &xd) { return new RK2T<long double>(x, xd, static_cast<Stepper&>(*this)); }
+      RK2T<Lanes>* factory(Lanes &x, Lanes &xd) { return new RK2T<Lanes>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
 
-      double xd0, xd1;
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); Binary::write(stream, xd0, xd1); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && Binary::read(stream, xd0, xd1); }
+
+      T xd0, xd1;
    };
+
+   using RK2 = RK2T<double>;
 }
\ No newline at end of file
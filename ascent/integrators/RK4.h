@@ -20,17 +20,28 @@
 
 namespace asc
 {
-   class RK4 : public StateStepper
+   template <typename T>
+   class RK4T : public StateStepper<T>
    {
    public:
-      RK4(Stepper &stepper) : StateStepper(x, xd, stepper) {}
-      RK4(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper) {}
+      ascStateStepper(T)
 
-      RK4* factory(double &x, double &xd) { return new RK4(x, xd, static_cast<Stepper&>(*this)); }
+      RK4T(Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+      RK4T(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+
+      RK4T<float>* factory(float &x, float &xd) { return new RK4T<float>(x, xd, static_cast<Stepper&>(*this)); }
+      RK4T<double>* factory(double &x, double &xd) { return new RK4T<double>(x, xd, static_cast<Stepper&>(*this)); }
+      RK4T<long double>* factory(long double &x, long double &xd) { return new RK4T<long double>(x, xd, static_cast<Stepper&>(*this)); }
+      RK4T<Lanes>* factory(Lanes &x, Lanes &xd) { return new RK4T<Lanes>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
 
-      double xd0, xd1, xd2, xd3;
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); Binary::write(stream, xd0, xd1, xd2, xd3); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && Binary::read(stream, xd0, xd1, xd2, xd3); }
+
+      T xd0, xd1, xd2, xd3;
    };
+
+   using RK4 = RK4T<double>;
 }
\ No newline at end of file
@@ -20,17 +20,28 @@
 
 namespace asc
 {
-   class RKMM : public StateStepper
+   template <typename T>
+   class RKMMT : public StateStepper<T>
    {
    public:
-      RKMM(Stepper &stepper) : StateStepper(x, xd, stepper) {}
-      RKMM(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper) {}
+      ascStateStepper(T)
 
-      RKMM* factory(double &x, double &xd) { return new RKMM(x, xd, static_cast<Stepper&>(*this)); }
+      RKMMT(Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+      RKMMT(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper) {}
+
+      RKMMT<float>* factory(float &x, float &xd) { return new RKMMT<float>(x, xd, static_cast<Stepper&>(*this)); }
+      RKMMT<double>* factory(double &x, double &xd) { return new RKMMT<double>(x, xd, static_cast<Stepper&>(*this)); }
+      RKMMT<long double>* factory(long double &x, long double &xd) { return new RKMMT<long double>(x, xd, static_cast<Stepper&>(*this)); }
+      RKMMT<Lanes>* factory(Lanes &x, Lanes &xd) { return new RKMMT<Lanes>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
 
-      double  k1, k2, k3, k4, k5;
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); Binary::write(stream, k1, k2, k3, k4, k5); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && Binary::read(stream, k1, k2, k3, k4, k5); }
+
+      T k1, k2, k3, k4, k5;
    };
+
+   using RKMM = RKMMT<double>;
 }
\ No newline at end of file
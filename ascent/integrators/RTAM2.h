@@ -23,18 +23,30 @@
 
 namespace asc
 {
-   class RTAM2 : public StateStepper
+   template <typename T>
+   class RTAM2T : public StateStepper<T>
    {
    public:
-      RTAM2(Stepper &stepper) : StateStepper(x, xd, stepper), initializer(new RK4(stepper)) {}
-      RTAM2(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper), initializer(new RK4(x, xd, stepper)) {}
+      ascStateStepper(T)
 
-      RTAM2* factory(double &x, double &xd) { return new RTAM2(x, xd, static_cast<Stepper&>(*this)); }
+      RTAM2T(Stepper &stepper) : StateStepper<T>(x, xd, stepper), initializer(new RK4T<T>(stepper)) {}
+      RTAM2T(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper), initializer(new RK4T<T>(x, xd, stepper)) {}
+
+      RTAM2T<float>* factory(float &x, float &xd) { return new RTAM2T<float>(x, xd, static_cast<Stepper&>(*this)); }
+      RTAM2T<double>* factory(double &x, double &xd) { return new RTAM2T<double>(x, xd, static_cast<Stepper&>(*this)); }
+      RTAM2T<long double>* factory(long double &x, long double &xd) { return new RTAM2T<long double>(x, xd, static_cast<Stepper&>(*this)); }
+      RTAM2T<Lanes>* factory(Lanes &x, Lanes &xd) { return new RTAM2T<Lanes>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
 
-      std::unique_ptr<RK4> initializer;
-      double xd_1; // -1, previous time step derivative
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); initializer->save(stream); Binary::write(stream, xd_1); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && initializer->load(stream) && Binary::read(stream, xd_1); }
+      bool still() const { return integrator_initialized && zero(xd) && zero(xd_1); } // and the derivative history
+
+      std::unique_ptr<RK4T<T>> initializer;
+      T xd_1; // -1, previous time step derivative
    };
+
+   using RTAM2 = RTAM2T<double>;
 }
\ No newline at end of file
@@ -25,22 +25,36 @@
 
 namespace asc
 {
-   class RTAM4 : public StateStepper
+   template <typename T>
+   class RTAM4T : public StateStepper<T>
    {
    public:
-      RTAM4(Stepper &stepper) : StateStepper(x, xd, stepper), initializer(new RK4(stepper)) {}
-      RTAM4(double &x, double &xd, Stepper &stepper) : StateStepper(x, xd, stepper), initializer(new RK4(x, xd, stepper)) {}
+      ascStateStepper(T)
 
-      RTAM4* factory(double &x, double &xd) { return new RTAM4(x, xd, static_cast<Stepper&>(*this)); }
+      RTAM4T(Stepper &stepper) : StateStepper<T>(x, xd, stepper), initializer(new RK4T<T>(stepper)) {}
+      RTAM4T(T &x, T &xd, Stepper &stepper) : StateStepper<T>(x, xd, stepper), initializer(new RK4T<T>(x, xd, stepper)) {}
+
+      RTAM4T<float>* factory(float &x, float &xd) { return new RTAM4T<float>(x, xd, static_cast<Stepper&>(*this)); }
+      RTAM4T<double>* factory(double &x, double &xd) { return new RTAM4T<double>(x, xd, static_cast<Stepper&>(*this)); }
+      RTAM4T<long double>* factory(long double &x, long double &xd) { return new RTAM4T<long double>(x, xd, static_cast<Stepper&>(*this)); }
+      RTAM4T<Lanes>* factory(Lanes &x, Lanes &xd) { return new RTAM4T<Lanes>(x, xd, static_cast<Stepper&>(*this)); }
 
       void propagate();
       void updateClock();
 
-      std::unique_ptr<RK4> initializer;
+      void save(std::ostream& stream) const { StateStepper<T>::save(stream); initializer->save(stream); Binary::write(stream, xd0, xd_1, xd_2, xd_3); }
+      bool load(std::istream& stream) { return StateStepper<T>::load(stream) && initializer->load(stream) && Binary::read(stream, xd0, xd_1, xd_2, xd_3); }
+      bool still() const { return integrator_initialized && zero(xd) && zero(xd_1) && zero(xd_2) && zero(xd_3); } // and the derivative history
+      void saveIntegrator(std::ostream& stream) const { Binary::write(stream, init_step); }
+      bool loadIntegrator(std::istream& stream) { return Binary::read(stream, init_step); }
+
+      std::unique_ptr<RK4T<T>> initializer;
       unsigned init_step = 0; // initialization step counter
-      double xd0;
-      double xd_1; // -1, previous time step derivative
-      double xd_2; // -2, two steps back
-      double xd_3; // -3, three steps back
+      T xd0;
+      T xd_1; // -1, previous time step derivative
+      T xd_2; // -2, two steps back
+      T xd_3; // -3, three steps back
    };
+
+   using RTAM4 = RTAM4T<double>;
 }
\ No newline at end of file
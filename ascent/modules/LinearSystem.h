@@ -0,0 +1,75 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Linear time-invariant system x' = Ax + Bu, y = Cx + Du, propagated by exact discretization rather than by an integrator.
+// The input is held constant over each full time step (zero order hold), so x(t0 + h) = Phi(h)*x(t0) + Gamma(h)*u(t0),
+// where Phi(h) = exp(A*h) and Gamma(h) = integral of exp(A*s)*B ds from 0 to h. Both come from one matrix exponential of the
+// augmented matrix [A B; 0 0]*h and are cached per step length, so they're only recomputed when the time step changes.
+// The propagation is exact and unconditionally stable for any time step, and costs a single matrix-vector product per pass.
+// States are also evaluated at the intermediate passes of the simulator's integrator, so that y is consistent with the stage times.
+
+#include "ascent/Module.h"
+
+#include <Eigen/Dense>
+
+#include <vector>
+
+namespace asc
+{
+   class LinearSystem : public Module
+   {
+   public:
+      LinearSystem(size_t sim) : Module(sim) {}
+      LinearSystem(size_t sim, const Eigen::MatrixXd& A, const Eigen::MatrixXd& B, const Eigen::MatrixXd& C, const Eigen::MatrixXd& D);
+
+      Eigen::MatrixXd A, B, C, D; // call matricesChanged() if these are modified after the simulation has started
+      Eigen::VectorXd x; // states
+      Eigen::VectorXd u; // inputs, set before this module's update() (i.e. via runBefore)
+      Eigen::VectorXd y; // outputs
+
+      void matricesChanged() { discretizations.clear(); } // forces the discretization to be recomputed
+
+      void init();
+      void update();
+      void postcalc();
+
+      // x, u, and y aren't integrated states, so checkpoints, forks, snapshots, and rollbacks save and restore them (with the step's initial
+      // values) here. The cached discretizations are recomputed on restore, from their step lengths.
+      void checkpoint(std::ostream& stream);
+      bool restore(std::istream& stream);
+
+      // x, u, and y are transferred with the integrated states (i.e. between Parareal slices).
+      void captureValues(std::vector<double>& values);
+      size_t seedValues(const std::vector<double>& values, const size_t i);
+
+   private:
+      struct Discretization
+      {
+         double h; // step length
+         Eigen::MatrixXd Phi; // state transition matrix
+         Eigen::MatrixXd Gamma; // input matrix
+      };
+
+      std::vector<Discretization> discretizations; // cached for the step lengths of the current time step (i.e. the stages of the integrator)
+      size_t max_discretizations = 16;
+
+      const Discretization& discretization(const double h);
+      void propagate(); // x at the current time from the state and input at the beginning of the step
+
+      double t0{}; // time at the beginning of the step
+      Eigen::VectorXd x0, u0;
+   };
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Lockstep co-simulation of a model that is split into subsystems, each in its own simulator and running on its own thread.
+// The subsystems advance in parallel from one sync point to the next (a macro step) and then wait at a barrier.
+// Coupled variables are exchanged through double buffered ports: after macro step k, producers write buffer (k + 1) % 2 while
+// consumers read buffer k % 2, so the ports need no locks and the barrier is the only synchronization between threads.
+// Between sync points, inputs are held at their sync point values, or extrapolated from previous sync point values (see Extrapolation.h).
+// Outputs are exchanged as they are at the sync points, so outputs should be updated by postcalc() (or be states).
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+#include "ascent/algorithms/Extrapolation.h"
+
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asc
+{
+   // Sets a coupled input from extrapolated sync point values before the consuming module updates.
+   class CoSimulationInput : public Module
+   {
+   public:
+      CoSimulationInput(const size_t sim, double& input, const size_t order) : Module(sim), input(input), order(order) {}
+
+      void sync(const double t_sync, const double x)
+      {
+         ts.push_back(t_sync);
+         xs.push_back(x);
+         if (ts.size() > order + 1)
+         {
+            ts.pop_front();
+            xs.pop_front();
+         }
+         input = x;
+      }
+
+      void update()
+      {
+         if (xs.size() < 2)
+            return;
+
+         const size_t degree = xs.size() - 1; // lower degree until enough sync points are available
+         double relative_error;
+         input = Extrapolation::extrapolate(ts, xs, t, relative_error, [degree](const double x)
+         {
+            Eigen::VectorXd terms(degree + 1);
+            terms(0) = 1.0;
+            for (size_t i = 1; i <= degree; ++i)
+               terms(i) = terms(i - 1) * x;
+            return terms;
+         });
+      }
+
+   private:
+      double& input;
+      const size_t order;
+      std::deque<double> ts, xs; // sync point times and values
+   };
+
+   class CoSimulation
+   {
+   public:
+      /** Add a subsystem.
+      * @param subsystem  A module that owns (i.e. via Links) the subsystem, which must be the only subsystem in its simulator.
+      * @param dt  The subsystem's time step, which must divide the macro step.
+      * @return Returns false if the subsystem's simulator already has a subsystem.
+      */
+      bool add(Link<Module> subsystem, const double dt)
+      {
+         if (index.count(subsystem->sim))
+            return subsystem->error("CoSimulation::add - simulator " + std::to_string(subsystem->sim) + " already has a subsystem.");
+
+         index[subsystem->sim] = subsystems.size();
+         subsystems.push_back(Subsystem{ subsystem, dt });
+         return true;
+      }
+
+      /** Couple an output of one subsystem to an input of another subsystem. Both variables must be doubles defined via define() (ascVar).
+      * @param from  Module (within a subsystem) that owns the output.
+      * @param to  Module (within another subsystem) that owns the input.
+      * @param extrapolation  Polynomial order of the input's extrapolation between sync points, 0 holds the input constant.
+      */
+      template <typename T1, typename T2>
+      bool connect(Link<T1>& from, const std::string& output, Link<T2>& to, const std::string& input, const size_t extrapolation = 0)
+      {
+         if (!index.count(from->sim) || !index.count(to->sim))
+            return to->error("CoSimulation::connect - modules must belong to added subsystems.");
+
+         Port port;
+         port.from = index[from->sim];
+         port.to = index[to->sim];
+         port.output = from->template variable<double>(output);
+         port.input = to->template variable<double>(input);
+         if (!port.output || !port.input)
+            return false;
+
+         port.buffer[0] = port.buffer[1] = *port.output;
+
+         if (extrapolation > 0)
+         {
+            port.extrapolate = Link<CoSimulationInput>(to->sim, *port.input, extrapolation);
+            port.extrapolating = true;
+            port.extrapolate->runBefore(to);
+         }
+
+         ports.push_back(port);
+         return true;
+      }
+
+      size_t macro_steps = 0; // macro steps completed by the last run()
+
+      /** Run all subsystems from their (common) current time to tend.
+      * @param macro_step  Time between sync points.
+      * @return Returns false if a subsystem ran into an error.
+      */
+      bool run(const double macro_step, const double tend)
+      {
+         if (subsystems.empty())
+            return false;
+
+         const double t0 = subsystems.front().module->t;
+         const size_t K = static_cast<size_t>(std::ceil((tend - t0) / macro_step - 1.0e-8));
+
+         for (auto& port : ports)
+            port.buffer[0] = *port.output;
+
+         Barrier barrier(subsystems.size());
+         std::atomic<bool> failed(false);
+
+         auto worker = [&](const size_t s)
+         {
+            Subsystem& subsystem = subsystems[s];
+            bool ok = subsystem.module->begin(subsystem.dt, tend); // setup and init() run once, each macro step then advances the same run
+            if (!ok)
+               failed = true;
+
+            for (size_t k = 0; k < K; ++k)
+            {
+               const double t_sync = t0 + k * macro_step;
+               const double t_next = (k + 1 == K) ? tend : t0 + (k + 1) * macro_step;
+
+               for (auto& port : ports) // read the inputs of this subsystem
+               {
+                  if (port.to != s)
+                     continue;
+                  const double x = port.buffer[k % 2];
+                  if (port.extrapolating)
+                     port.extrapolate->sync(t_sync, x);
+                  else
+                     *port.input = x;
+               }
+
+               if (ok && !subsystem.module->advanceTo(t_next))
+               {
+                  ok = false;
+                  failed = true;
+               }
+
+               for (auto& port : ports) // write the outputs of this subsystem
+               {
+                  if (port.from == s)
+                     port.buffer[(k + 1) % 2] = *port.output;
+               }
+
+               if (barrier.wait(!ok)) // every thread sees the same outcome of a macro step, so they all stop together
+                  break;
+            }
+
+            subsystem.module->end();
+         };
+
+         std::vector<std::thread> pool;
+         for (size_t s = 1; s < subsystems.size(); ++s)
+            pool.emplace_back(worker, s);
+         worker(0);
+         for (auto& thread : pool)
+            thread.join();
+
+         macro_steps = K;
+         return !failed;
+      }
+
+   private:
+      struct Subsystem
+      {
+         Link<Module> module;
+         double dt;
+      };
+
+      struct Port
+      {
+         size_t from{}, to{}; // subsystem indices
+         double* output{};
+         double* input{};
+         double buffer[2]{};
+         Link<CoSimulationInput> extrapolate;
+         bool extrapolating = false;
+      };
+
+      class Barrier
+      {
+      public:
+         Barrier(const size_t n) : n(n) {}
+
+         // Returns whether any thread failed by this generation, as captured when the last thread arrived.
+         bool wait(const bool fail)
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+            const size_t current = generation;
+            failing = failing || fail;
+            if (++count == n)
+            {
+               count = 0;
+               failed = failing;
+               ++generation;
+               condition.notify_all();
+            }
+            else
+               condition.wait(lock, [&] { return generation != current; });
+            return failed; // the next generation can't be released before this thread arrives, so failed is still this generation's
+         }
+
+      private:
+         std::mutex mutex;
+         std::condition_variable condition;
+         const size_t n;
+         size_t count = 0;
+         size_t generation = 0;
+         bool failing = false; // of the current generation (and earlier ones)
+         bool failed = false; // of the last released generation
+      };
+
+      std::vector<Subsystem> subsystems;
+      std::map<size_t, size_t> index; // simulator number to subsystem index
+      std::vector<Port> ports;
+   };
+}
\ No newline at end of file
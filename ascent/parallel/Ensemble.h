@@ -0,0 +1,190 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Parallel Monte Carlo ensembles. Every run builds its model on a worker's simulator with a factory, applies its seed and
+// parameter overrides, runs, and reduces the model to scalar outputs. Only the outputs are kept (one value per run and output),
+// not the runs' histories, and they are aggregated into statistics. Statistics are computed in run order, so results don't
+// depend upon thread scheduling.
+// Workers build, run, and destroy their models concurrently, each on its own simulator.
+
+#include "ascent/Link.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asc
+{
+   struct EnsembleRun
+   {
+      size_t run{}; // run index
+      uint64_t seed{}; // seed for this run's random numbers
+      std::map<std::string, double> overrides; // variables (define() or ascVar) to be set on the factory's module
+   };
+
+   struct EnsembleStatistics
+   {
+      size_t n{};
+      double mean{};
+      double variance{}; // sample variance
+      double min = std::numeric_limits<double>::infinity();
+      double max = -std::numeric_limits<double>::infinity();
+
+      double stdDeviation() const { return std::sqrt(variance); }
+
+      /** Percentile with linear interpolation between ranks.
+      * @param p  Percentile from 0 to 100.
+      */
+      double percentile(const double p) const
+      {
+         if (sorted.empty())
+            return std::numeric_limits<double>::quiet_NaN();
+
+         const double rank = std::min(std::max(p, 0.0), 100.0) / 100.0 * (sorted.size() - 1);
+         const size_t i = static_cast<size_t>(rank);
+         if (i + 1 >= sorted.size())
+            return sorted.back();
+         return sorted[i] + (rank - i) * (sorted[i + 1] - sorted[i]);
+      }
+
+      void compute(const std::vector<double>& values) // Welford's algorithm, non-finite values (i.e. failed runs) are excluded
+      {
+         *this = EnsembleStatistics();
+         double m2 = 0.0;
+         for (double x : values)
+         {
+            if (!std::isfinite(x))
+               continue;
+            ++n;
+            const double delta = x - mean;
+            mean += delta / n;
+            m2 += delta * (x - mean);
+            min = std::min(min, x);
+            max = std::max(max, x);
+            sorted.push_back(x);
+         }
+         variance = n > 1 ? m2 / (n - 1) : 0.0;
+         std::sort(sorted.begin(), sorted.end());
+      }
+
+   private:
+      std::vector<double> sorted;
+   };
+
+   class Ensemble
+   {
+   public:
+      using Factory = std::function<Link<Module>(const size_t sim, const EnsembleRun& run)>;
+      using Output = std::function<double(Link<Module>& model)>;
+
+      /**
+      * @param factory  Builds one run's model in the given simulator (including setting the integrator via asc::integrator<T>(sim)),
+      * returning a module that owns (i.e. via Links) the rest of the model. The run's overrides are set on this module after it is built.
+      * @param first_sim  Simulator number of the first worker, each worker uses the following simulator numbers.
+      */
+      Ensemble(Factory factory, const size_t first_sim) : factory(factory), first_sim(first_sim) {}
+
+      size_t threads = std::max(1u, std::thread::hardware_concurrency());
+      uint64_t seed = 0; // base seed, each run's seed is derived from it and the run index
+      std::vector<std::map<std::string, double>> overrides; // parameter overrides per run (optional, indexed by run)
+
+      /** Select an output, evaluated at the end of every run. */
+      void output(const std::string& name, Output f) { outputs.emplace_back(name, f); }
+
+      /** Select a double variable (define() or ascVar) of the factory's module as an output. */
+      void output(const std::string& name) { output(name, [name](Link<Module>& model) { return model->get<double>(name); }); }
+
+      /** Run the ensemble.
+      * @return Returns false if any run failed, failed runs have non-finite outputs and are excluded from the statistics.
+      */
+      bool run(const size_t runs, const double dt, const double tend)
+      {
+         values.assign(outputs.size(), std::vector<double>(runs, std::numeric_limits<double>::quiet_NaN()));
+         failed = 0;
+
+         std::atomic<size_t> next(0);
+         std::atomic<size_t> failures(0);
+
+         auto worker = [&](const size_t sim)
+         {
+            for (size_t i = next++; i < runs; i = next++)
+            {
+               EnsembleRun r;
+               r.run = i;
+               r.seed = runSeed(i);
+               if (i < overrides.size())
+                  r.overrides = overrides[i];
+
+               Link<Module> model = factory(sim, r);
+               model->randomSeed(r.seed, r.run); // the modules' random streams (Module::random()) depend on the run rather than the worker
+
+               bool ok = true;
+               for (auto& p : r.overrides)
+                  ok = ok && model->set<double>(p.first, p.second);
+
+               ok = ok && model->run(dt, tend);
+
+               if (ok)
+               {
+                  for (size_t k = 0; k < outputs.size(); ++k)
+                     values[k][i] = outputs[k].second(model);
+               }
+               else
+                  ++failures;
+            }
+         };
+
+         std::vector<std::thread> pool;
+         const size_t count = std::max<size_t>(1, std::min(threads, runs));
+         for (size_t w = 1; w < count; ++w)
+            pool.emplace_back(worker, first_sim + w);
+         worker(first_sim);
+         for (auto& thread : pool)
+            thread.join();
+
+         failed = failures;
+
+         statistics.clear();
+         for (size_t k = 0; k < outputs.size(); ++k)
+            statistics[outputs[k].first].compute(values[k]);
+
+         return failed == 0;
+      }
+
+      std::map<std::string, EnsembleStatistics> statistics; // statistics of each output after run()
+      std::vector<std::vector<double>> values; // values[output][run], in the order that outputs were selected
+      size_t failed = 0; // number of failed runs
+
+      uint64_t runSeed(const size_t run) const // splitmix64, so that neighboring runs get uncorrelated seeds
+      {
+         uint64_t z = seed + 0x9E3779B97F4A7C15ull * (run + 1);
+         z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+         z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+         return z ^ (z >> 31);
+      }
+
+   private:
+      Factory factory;
+      const size_t first_sim;
+      std::vector<std::pair<std::string, Output>> outputs;
+   };
+}
\ No newline at end of file
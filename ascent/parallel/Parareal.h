@@ -0,0 +1,184 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Parareal parallel-in-time integration for long simulations.
+// [t, tend] is divided into time slices. A cheap coarse integrator (Coarse at a large time step) predicts the states at the beginning
+// of every slice serially, then fine integrators (Fine at a small time step) integrate all slices in parallel from the predicted states,
+// on cloned simulators. The predictions are corrected, U[n + 1] = G(U[n]) + F(U_prev[n]) - G(U_prev[n]), and the iteration repeats
+// until the slice states converge. The result equals the serial fine solution after at most one iteration per slice.
+// Only integrated states (every lane of lane states) and the values of Module::captureValues() are transferred between slices (see Module::seedStates()),
+// so models must compute everything else from them. Histories of the coarse and fine models are cleared before every slice run, so they
+// don't grow with the slices and iterations and hold the last slice each model integrated. Record complete trajectories with a separate serial run.
+// Source: J.-L. Lions, Y. Maday, G. Turinici. A "parareal" in time discretization of PDE's. C. R. Acad. Sci. Paris, 2001.
+
+#include "ascent/Link.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace asc
+{
+   template <typename Coarse, typename Fine>
+   class Parareal
+   {
+   public:
+      using Factory = std::function<Link<Module>(const size_t sim)>;
+
+      /**
+      * @param factory  Builds one instance of the model in the given simulator and returns a module that owns (i.e. via Links) the rest of the model.
+      * Called serially, every instance must add its states in the same order.
+      * @param slices  Number of time slices, each slice is integrated by its own fine simulator.
+      * @param first_sim  Simulator number of the coarse model, the fine models use the following simulator numbers.
+      */
+      Parareal(Factory factory, const size_t slices, const size_t first_sim)
+      {
+         integrator<Coarse>(first_sim);
+         coarse = factory(first_sim);
+
+         for (size_t n = 0; n < slices; ++n)
+         {
+            integrator<Fine>(first_sim + 1 + n);
+            fine.push_back(factory(first_sim + 1 + n));
+         }
+      }
+
+      double tolerance = 1.0e-8; // convergence tolerance for the slice states, relative to (1 + |x|)
+      size_t max_iterations = 0; // 0 iterates until convergence
+      size_t threads = std::max(1u, std::thread::hardware_concurrency()); // maximum number of fine slices integrated concurrently
+
+      size_t iterations = 0; // iterations used by the last run()
+      std::vector<double> T; // slice boundary times
+      std::vector<std::vector<double>> U; // states at the slice boundaries, U.back() is the solution at tend
+
+      Link<Module> coarse; // its initial states and time are the initial conditions
+      std::vector<Link<Module>> fine; // after run(), fine.back() holds the fine model at tend
+
+      /** Integrate from the coarse model's time to tend.
+      * @return Returns false if a simulator ran into an error.
+      */
+      bool run(const double dt_coarse, const double dt_fine, const double tend)
+      {
+         const size_t N = fine.size();
+         const double t0 = coarse->t;
+
+         T.resize(N + 1);
+         for (size_t n = 0; n <= N; ++n)
+            T[n] = t0 + (tend - t0) * n / N;
+         T[N] = tend;
+
+         // Initial coarse prediction
+         U.assign(N + 1, {});
+         U[0] = coarse->captureStates();
+         std::vector<std::vector<double>> G(N), F(N); // coarse and fine solutions at the end of each slice
+
+         for (size_t n = 0; n < N; ++n)
+         {
+            if (!propagate(coarse, U[n], n, dt_coarse, G[n]))
+               return false;
+            U[n + 1] = G[n];
+         }
+
+         const size_t k_max = max_iterations > 0 ? std::min(max_iterations, N) : N;
+         for (iterations = 1; iterations <= k_max; ++iterations)
+         {
+            // Slices before k - 1 are exact, because they start from converged states.
+            const size_t first = iterations - 1;
+            if (!fineSlices(first, dt_fine, F))
+               return false;
+
+            // Serial correction
+            double change = 0.0;
+            std::vector<double> g;
+            for (size_t n = first; n < N; ++n)
+            {
+               if (n == first)
+                  g = G[n]; // U[first] is unchanged, so the coarse solution is too
+               else if (!propagate(coarse, U[n], n, dt_coarse, g))
+                  return false;
+
+               std::vector<double> u(g.size());
+               for (size_t i = 0; i < g.size(); ++i)
+               {
+                  u[i] = g[i] + F[n][i] - G[n][i];
+                  change = std::max(change, std::abs(u[i] - U[n + 1][i]) / (1.0 + std::abs(u[i])));
+               }
+
+               G[n] = g;
+               U[n + 1] = u;
+            }
+
+            if (change <= tolerance)
+               break;
+         }
+         iterations = std::min(iterations, k_max);
+
+         // Leave the coarse and last fine models at tend, so that a following run() continues from the solution.
+         return coarse->seedStates(U[N], tend) && fine.back()->seedStates(U[N], tend);
+      }
+
+   private:
+      // Integrates a model over slice n from the states x, returning the states at the end of the slice.
+      bool propagate(Link<Module>& model, const std::vector<double>& x, const size_t n, const double dt, std::vector<double>& result)
+      {
+         if (!model->seedStates(x, T[n]))
+            return false;
+         model->clearHistories();
+         if (!model->run(dt, T[n + 1]))
+            return false;
+         result = model->captureStates();
+         return true;
+      }
+
+      bool fineSlices(const size_t first, const double dt, std::vector<std::vector<double>>& F)
+      {
+         const size_t N = fine.size();
+
+         // Seeding initializes modules, which may create modules, so it is done serially.
+         for (size_t n = first; n < N; ++n)
+         {
+            if (!fine[n]->seedStates(U[n], T[n]))
+               return false;
+            fine[n]->clearHistories();
+         }
+
+         std::atomic<size_t> next(first);
+         std::atomic<bool> ok(true);
+         auto worker = [&]()
+         {
+            for (size_t n = next++; n < N; n = next++)
+            {
+               if (!fine[n]->run(dt, T[n + 1]))
+                  ok = false;
+               F[n] = fine[n]->captureStates();
+            }
+         };
+
+         std::vector<std::thread> pool;
+         const size_t count = std::min(threads, N - first);
+         for (size_t i = 1; i < count; ++i)
+            pool.emplace_back(worker);
+         worker();
+         for (auto& thread : pool)
+            thread.join();
+
+         return ok;
+      }
+   };
+}
\ No newline at end of file
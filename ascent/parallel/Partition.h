@@ -0,0 +1,406 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Partitioned simulation across local worker processes (POSIX, i.e. Linux). The launcher (run()) forks one process per worker and each
+// worker builds its part of the model, in its own simulator, via a factory. Workers advance in lockstep macro steps and exchange
+// boundary variables through a shared memory segment. Every port is double buffered. After a macro step, each worker publishes its
+// outputs and then its step count, with release/acquire atomics. A worker reads its inputs once every worker has published, so the
+// handshake is lock-free. Gathered variable histories are sent back to the launcher through pipes when the workers finish.
+// Launch from a single threaded program, since workers are forked.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+#include "ascent/core/Binary.h"
+
+#if defined(__unix__)
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace asc
+{
+   class Partition
+   {
+   public:
+      using Factory = std::function<Link<Module>(const size_t worker, Partition& partition)>;
+
+      Partition(const size_t workers) : workers(workers) {}
+
+      ~Partition() { unmap(); }
+
+      /** Declare a boundary variable, before run().
+      * @param name  Port name.
+      * @param worker  The worker that outputs the port.
+      * @return Returns false if the port was already declared.
+      */
+      bool port(const std::string& name, const size_t worker)
+      {
+         if (ports.count(name))
+            return false;
+
+         const size_t index = ports.size(); // taken before inserting, so that indices run from 0 to ports.size() - 1
+         ports.emplace(name, Port{ index, worker });
+         return true;
+      }
+
+      // Called by the factory, within a worker:
+
+      /** Publish a double variable (define() or ascVar) of a module of this worker's model to a port, at every sync point. */
+      template <typename T>
+      bool output(Link<T>& module, const std::string& var, const std::string& port)
+      {
+         if (!ports.count(port) || ports[port].worker != worker)
+            return module->error("Partition::output - port <" + port + "> isn't an output of worker " + std::to_string(worker) + ".");
+
+         double* x = module->template variable<double>(var);
+         if (x)
+            outputs.emplace_back(ports[port].index, x);
+         return x != nullptr;
+      }
+
+      /** Set a double variable (define() or ascVar) of a module of this worker's model from a port, at every sync point. */
+      template <typename T>
+      bool input(Link<T>& module, const std::string& var, const std::string& port)
+      {
+         if (!ports.count(port))
+            return module->error("Partition::input - port <" + port + "> wasn't declared.");
+
+         double* x = module->template variable<double>(var);
+         if (x)
+            inputs.emplace_back(ports[port].index, x);
+         return x != nullptr;
+      }
+
+      /** Track a double variable (define() or ascVar), whose history is sent to the launcher at the end of the run.
+      * @param key  Name of the history in results (and of its time history in times).
+      */
+      template <typename T>
+      bool gather(Link<T>& module, const std::string& var, const std::string& key)
+      {
+         if (!module->template variable<double>(var))
+            return false;
+
+         module->track(var);
+         Link<Module> m = module;
+         gathers.push_back([m, var, key](std::ostream& stream) mutable
+         {
+            const std::deque<double> x = m->template history<double>(var);
+            const std::vector<double>& t = m->timeHistory();
+            std::vector<double> tx; // times of the history's (most recent) values
+            if (t.size() >= x.size())
+               tx.assign(t.end() - x.size(), t.end());
+            return Binary::write(stream, key, std::vector<double>(x.begin(), x.end()), tx);
+         });
+         return true;
+      }
+
+      size_t worker = 0; // within a worker process, the worker's index
+
+      std::map<std::string, std::vector<double>> results; // gathered histories, after run()
+      std::map<std::string, std::vector<double>> times; // time histories of the gathered histories
+
+      /** Launch the workers and run them from time zero to tend.
+      * @param factory  Builds worker's part of the model, within the worker's process. Returns a module that owns (i.e. via Links) that part.
+      * @param dt  Time step of every worker.
+      * @param macro_step  Time between exchanges of boundary variables.
+      * @return Returns false if a worker failed.
+      */
+      bool run(Factory factory, const double dt, const double macro_step, const double tend)
+      {
+         results.clear();
+         times.clear();
+
+         if (!map())
+            return false;
+
+         std::vector<pid_t> pids(workers, -1);
+         std::vector<int> pipes(workers, -1);
+         for (size_t w = 0; w < workers; ++w)
+         {
+            int fd[2];
+            if (pipe(fd) != 0)
+               return abort(pids, pipes);
+
+            const pid_t pid = fork();
+            if (pid < 0)
+            {
+               close(fd[0]);
+               close(fd[1]);
+               return abort(pids, pipes);
+            }
+
+            if (pid == 0) // worker process
+            {
+               close(fd[0]);
+               for (size_t i = 0; i < w; ++i)
+                  close(pipes[i]);
+               worker = w;
+               const bool ok = work(factory, dt, macro_step, tend, fd[1]);
+               close(fd[1]);
+               _exit(ok ? 0 : 1);
+            }
+
+            close(fd[1]);
+            pids[w] = pid;
+            pipes[w] = fd[0];
+         }
+
+         const bool ok = collect(pids, pipes);
+         unmap();
+         return ok;
+      }
+
+   private:
+      struct Port
+      {
+         size_t index;
+         size_t worker; // the worker that outputs this port
+      };
+
+      struct alignas(64) Counter // a cache line per worker, so that workers don't write to each other's lines
+      {
+         std::atomic<uint64_t> steps; // sync points published by the worker
+      };
+
+      static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared memory handshakes require lock-free (address free) atomics.");
+
+      const size_t workers;
+      std::map<std::string, Port> ports;
+      std::vector<std::pair<size_t, double*>> outputs, inputs; // within a worker
+      std::vector<std::function<bool(std::ostream& stream)>> gathers; // within a worker
+
+      // shared memory segment: failed flag, worker counters, then buffer[2][ports]
+      void* segment = nullptr;
+      size_t segment_size = 0;
+      std::atomic<bool>* failed = nullptr;
+      Counter* counters = nullptr;
+      double* buffers = nullptr;
+
+      double& buffer(const size_t k, const size_t port) { return buffers[(k % 2) * ports.size() + port]; }
+
+      bool map()
+      {
+         segment_size = sizeof(Counter) * (workers + 1) + 2 * ports.size() * sizeof(double);
+
+         // The segment is unlinked as soon as it is mapped, forked workers inherit the mapping and nothing is left behind if a process dies.
+         const std::string name = "/ascent_partition_" + std::to_string(getpid());
+         const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+         if (fd < 0)
+            return false;
+         shm_unlink(name.c_str());
+
+         if (ftruncate(fd, static_cast<off_t>(segment_size)) != 0)
+         {
+            close(fd);
+            return false;
+         }
+
+         segment = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+         close(fd);
+         if (segment == MAP_FAILED)
+         {
+            segment = nullptr;
+            return false;
+         }
+
+         char* p = static_cast<char*>(segment);
+         failed = new (p) std::atomic<bool>(false);
+         counters = reinterpret_cast<Counter*>(p + sizeof(Counter));
+         for (size_t w = 0; w < workers; ++w)
+            new (&counters[w].steps) std::atomic<uint64_t>(0);
+         buffers = reinterpret_cast<double*>(p + sizeof(Counter) * (workers + 1));
+         return true;
+      }
+
+      void unmap()
+      {
+         if (segment)
+            munmap(segment, segment_size);
+         segment = nullptr;
+      }
+
+      bool abort(std::vector<pid_t>& pids, std::vector<int>& pipes)
+      {
+         failed->store(true);
+         for (int& fd : pipes) // closing the read ends also releases workers that block on writing their results
+         {
+            if (fd >= 0)
+               close(fd);
+            fd = -1;
+         }
+
+         for (pid_t pid : pids)
+         {
+            if (pid > 0)
+               waitpid(pid, nullptr, 0);
+         }
+         unmap();
+         return false;
+      }
+
+      bool wait(const uint64_t steps) // waits until every worker has published the given number of sync points
+      {
+         for (size_t w = 0; w < workers; ++w)
+         {
+            while (counters[w].steps.load(std::memory_order_acquire) < steps)
+            {
+               if (failed->load(std::memory_order_relaxed))
+                  return false;
+               std::this_thread::yield();
+            }
+         }
+         return true;
+      }
+
+      void publish(const size_t k) // outputs at sync point k
+      {
+         for (auto& p : outputs)
+            buffer(k, p.first) = *p.second;
+         counters[worker].steps.store(k + 1, std::memory_order_release);
+      }
+
+      bool work(Factory& factory, const double dt, const double macro_step, const double tend, const int pipe)
+      {
+         Link<Module> model = factory(worker, *this);
+
+         const size_t K = static_cast<size_t>(std::ceil(tend / macro_step - 1.0e-8));
+         bool ok = model->begin(dt, tend); // setup and init() run once, each macro step then advances the same run
+
+         if (ok)
+            publish(0);
+         for (size_t k = 0; k < K && ok; ++k)
+         {
+            ok = wait(k + 1);
+            if (!ok)
+               break;
+
+            for (auto& p : inputs)
+               *p.second = buffer(k, p.first);
+
+            ok = model->advanceTo((k + 1 == K) ? tend : (k + 1) * macro_step);
+            if (ok)
+               publish(k + 1);
+         }
+         ok = model->end() && ok;
+
+         if (!ok)
+            failed->store(true);
+
+         std::ostringstream stream;
+         for (auto& gather : gathers)
+            ok = ok && gather(stream);
+
+         const std::string data = stream.str();
+         for (size_t n = 0; n < data.size();)
+         {
+            const ssize_t written = write(pipe, data.data() + n, data.size() - n);
+            if (written <= 0)
+               return false;
+            n += static_cast<size_t>(written);
+         }
+         return ok;
+      }
+
+      bool collect(std::vector<pid_t>& pids, std::vector<int>& pipes)
+      {
+         // Pipes are drained while waiting, so that workers never block on writing their results.
+         std::vector<std::string> data(workers);
+         size_t open = workers, running = workers;
+         bool ok = true;
+         char chunk[65536];
+
+         while (open > 0 || running > 0)
+         {
+            std::vector<pollfd> fds;
+            std::vector<size_t> owners;
+            for (size_t w = 0; w < workers; ++w)
+            {
+               if (pipes[w] >= 0)
+               {
+                  fds.push_back(pollfd{ pipes[w], POLLIN, 0 });
+                  owners.push_back(w);
+               }
+            }
+
+            if (!fds.empty() && poll(fds.data(), fds.size(), 50) > 0)
+            {
+               for (size_t i = 0; i < fds.size(); ++i)
+               {
+                  if (!fds[i].revents)
+                     continue;
+                  const ssize_t n = read(fds[i].fd, chunk, sizeof(chunk));
+                  if (n > 0)
+                     data[owners[i]].append(chunk, static_cast<size_t>(n));
+                  else
+                  {
+                     close(fds[i].fd);
+                     pipes[owners[i]] = -1;
+                     --open;
+                  }
+               }
+            }
+            else if (fds.empty())
+               std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            for (auto& pid : pids) // only this run's workers are reaped, other children of the host process are left alone
+            {
+               int status;
+               if (pid > 0 && waitpid(pid, &status, WNOHANG) == pid)
+               {
+                  pid = -1;
+                  --running;
+                  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                  {
+                     ok = false;
+                     failed->store(true); // releases workers waiting for a crashed worker
+                  }
+               }
+            }
+         }
+
+         for (auto& d : data)
+         {
+            std::istringstream stream(d);
+            std::string key;
+            std::vector<double> x, t;
+            while (stream.peek() != EOF && Binary::read(stream, key, x, t))
+            {
+               results[key] = x;
+               times[key] = t;
+            }
+         }
+
+         return ok;
+      }
+   };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,361 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Optimistic (Time Warp) parallel simulation of loosely coupled models, each model (a logical process) in its own simulator and thread.
+// Models interact only through timestamped messages, and every model runs ahead without waiting for the others. Each model begins one
+// run and advances it (advanceTo()) from stop to stop, at window boundaries and message times. At every stop it saves its simulator
+// in an in-memory checkpoint without histories, so the cost of a save doesn't grow with the length of the run. A message with a timestamp in a
+// model's past (a straggler) rolls that model back to its last saved state before the message and the model re-executes. Messages the
+// model sent at or after the rollback time are cancelled with anti-messages, which can roll back their receivers in turn. Re-execution
+// is deterministic, so messages sent before the rollback time stay valid and are not sent again.
+// Saved states older than the global virtual time (GVT, which no rollback can precede) are discarded as models advance.
+// Source: D. R. Jefferson. Virtual Time. ACM Transactions on Programming Languages and Systems, 1985.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace asc
+{
+   struct TimeWarpMessage
+   {
+      double time{}; // receive time
+      double send_time{};
+      size_t from{}, to{}; // logical processes
+      uint64_t id{}; // sequence number of the sender
+      bool anti = false; // cancels the message with the same sender and id
+      std::string var; // variable (define() or ascVar) of the receiver's model that is set to value, unless a receive handler is used
+      double value{};
+
+      bool operator < (const TimeWarpMessage& m) const { return std::tie(time, from, id) < std::tie(m.time, m.from, m.id); }
+   };
+
+   class TimeWarp
+   {
+   public:
+      using Factory = std::function<Link<Module>(const size_t sim, const size_t process, TimeWarp& time_warp)>;
+      using Receive = std::function<void(Link<Module>& model, const TimeWarpMessage& message)>;
+
+      /**
+      * @param factory  Builds a logical process' model in the given simulator. Its modules send messages via send(process, ...).
+      * Models must be deterministic, must not create or delete modules while running, and must restart from checkpoints (see Simulator::checkpoint()).
+      * @param processes  Number of logical processes.
+      * @param first_sim  Simulator number of the first process, the other processes use the following simulator numbers.
+      */
+      TimeWarp(Factory factory, const size_t processes, const size_t first_sim) : processes(processes), lps(processes)
+      {
+         for (size_t p = 0; p < processes; ++p)
+         {
+            lps[p].model = factory(first_sim + p, p, *this);
+            lps[p].clock = &lps[p].model->t;
+         }
+      }
+
+      Receive receive; // optional handler for received messages, by default a message sets a double variable of the receiving model
+
+      Link<Module>& model(const size_t process) { return lps[process].model; }
+
+      /** Send a message, called by a module of the sending process while it runs.
+      * @param time  Receive time, which can't precede the sender's current time.
+      */
+      bool send(const size_t from, const size_t to, const double time, const std::string& var, const double value)
+      {
+         Process& sender = lps[from];
+         const double send_time = *sender.clock;
+         if (time < send_time || to >= processes)
+            return false;
+
+         if (send_time < sender.coast_until) // re-executing after a rollback, this message was already sent
+            return true;
+
+         TimeWarpMessage message;
+         message.time = time;
+         message.send_time = send_time;
+         message.from = from;
+         message.to = to;
+         message.id = sender.next_id++;
+         message.var = var;
+         message.value = value;
+
+         sender.sent.push_back(message);
+         post(message);
+         ++messages_sent;
+         return true;
+      }
+
+      std::atomic<size_t> rollbacks{}; // statistics of the last run()
+      std::atomic<size_t> messages_sent{};
+      std::atomic<size_t> anti_messages{};
+
+      /** Run all processes from time zero to tend.
+      * @param window  Longest advance between saved states, smaller windows save more often but re-execute less on rollbacks.
+      */
+      bool run(const double dt, const double window, const double tend)
+      {
+         rollbacks = messages_sent = anti_messages = 0;
+         finished = false;
+         failed = false;
+
+         std::vector<std::thread> pool;
+         for (size_t p = 1; p < processes; ++p)
+            pool.emplace_back(&TimeWarp::process, this, p, dt, window, tend);
+         process(0, dt, window, tend);
+         for (auto& thread : pool)
+            thread.join();
+
+         for (auto& lp : lps)
+            lp.model->end();
+
+         return !failed;
+      }
+
+   private:
+      struct Save
+      {
+         double t;
+         std::string state; // in-memory checkpoint
+         size_t sent; // number of messages sent when saved
+      };
+
+      struct Process
+      {
+         Link<Module> model;
+         const double* clock = nullptr; // the model's time, read without Link access while running
+
+         // guarded by mutex
+         std::vector<TimeWarpMessage> inbox;
+         bool idle = false;
+         double floor = 0.0; // earliest time this process can roll back to
+
+         // only accessed by the process' thread
+         std::vector<TimeWarpMessage> pending; // sorted by time
+         std::vector<TimeWarpMessage> processed;
+         std::vector<TimeWarpMessage> sent;
+         std::deque<Save> saves;
+         uint64_t next_id = 0;
+         double coast_until = -std::numeric_limits<double>::infinity();
+      };
+
+      const size_t processes;
+      std::vector<Process> lps;
+
+      std::mutex mutex;
+      std::condition_variable condition;
+      bool finished = false;
+      bool failed = false;
+
+      const double eps = 1.0e-8; // time tolerance, advanceTo() treats a target within the simulator's EPS as reached
+
+      void post(const TimeWarpMessage& message)
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         Process& receiver = lps[message.to];
+         receiver.inbox.push_back(message);
+         receiver.idle = false;
+         condition.notify_all();
+      }
+
+      void save(Process& lp)
+      {
+         std::ostringstream stream;
+         lp.model->saveCheckpoint(stream, false);
+         lp.saves.push_back(Save{ *lp.clock, stream.str(), lp.sent.size() });
+      }
+
+      bool rollback(Process& lp, const double t)
+      {
+         ++rollbacks;
+
+         while (lp.saves.size() > 1 && lp.saves.back().t > t)
+            lp.saves.pop_back();
+         Save& s = lp.saves.back();
+
+         std::istringstream stream(s.state);
+         if (!lp.model->loadCheckpoint(stream))
+            return false;
+
+         // cancel messages sent at or after the rollback time, earlier messages are still valid
+         auto first = std::stable_partition(lp.sent.begin() + s.sent, lp.sent.end(), [t](const TimeWarpMessage& m) { return m.send_time < t; });
+         for (auto it = first; it != lp.sent.end(); ++it)
+         {
+            TimeWarpMessage anti = *it;
+            anti.anti = true;
+            post(anti);
+            ++anti_messages;
+         }
+         lp.sent.erase(first, lp.sent.end());
+         lp.coast_until = t;
+
+         // messages processed since the save are processed again
+         for (auto it = lp.processed.begin(); it != lp.processed.end();)
+         {
+            if (it->time >= s.t)
+            {
+               lp.pending.insert(std::upper_bound(lp.pending.begin(), lp.pending.end(), *it), *it);
+               it = lp.processed.erase(it);
+            }
+            else
+               ++it;
+         }
+         return true;
+      }
+
+      bool deliver(Process& lp, const TimeWarpMessage& message)
+      {
+         const double t = *lp.clock;
+         auto same = [&message](const TimeWarpMessage& m) { return m.from == message.from && m.id == message.id; };
+
+         if (message.anti)
+         {
+            if (std::find_if(lp.processed.begin(), lp.processed.end(), same) != lp.processed.end())
+            {
+               if (!rollback(lp, message.time))
+                  return false;
+            }
+            auto it = std::find_if(lp.pending.begin(), lp.pending.end(), same);
+            if (it != lp.pending.end())
+               lp.pending.erase(it);
+            return true;
+         }
+
+         // A straggler is in the past, or is due now but sorts before messages that were already applied (so that application order is deterministic).
+         if (message.time < t || (message.time <= t && !lp.processed.empty() && message < lp.processed.back()))
+         {
+            if (!rollback(lp, message.time))
+               return false;
+         }
+
+         lp.pending.insert(std::upper_bound(lp.pending.begin(), lp.pending.end(), message), message);
+         return true;
+      }
+
+      void apply(Process& lp) // applies messages that are due at the current time
+      {
+         const double t = *lp.clock;
+         while (!lp.pending.empty() && lp.pending.front().time <= t + eps)
+         {
+            const TimeWarpMessage& m = lp.pending.front();
+            if (receive)
+               receive(lp.model, m);
+            else if (double* x = lp.model->variable<double>(m.var))
+               *x = m.value;
+            lp.processed.push_back(m);
+            lp.pending.erase(lp.pending.begin());
+         }
+      }
+
+      void collect(Process& lp, const double gvt) // discards saved states and processed messages that no rollback can reach
+      {
+         while (lp.saves.size() > 1 && lp.saves[1].t <= gvt)
+            lp.saves.pop_front();
+         const double t_oldest = lp.saves.front().t;
+         lp.processed.erase(std::remove_if(lp.processed.begin(), lp.processed.end(), [t_oldest](const TimeWarpMessage& m) { return m.time < t_oldest; }), lp.processed.end());
+         const size_t sent_oldest = lp.saves.front().sent;
+         if (sent_oldest > 0)
+         {
+            lp.sent.erase(lp.sent.begin(), lp.sent.begin() + sent_oldest);
+            for (auto& s : lp.saves)
+               s.sent -= sent_oldest;
+         }
+      }
+
+      void process(const size_t p, const double dt, const double window, const double tend)
+      {
+         Process& lp = lps[p];
+
+         lp.saves.clear();
+         if (!lp.model->begin(dt, tend)) // setup and init() run once, rollbacks restore checkpoints of the same run
+            return fail();
+         save(lp);
+
+         while (true)
+         {
+            std::vector<TimeWarpMessage> inbox;
+            double gvt = std::numeric_limits<double>::infinity();
+            {
+               std::unique_lock<std::mutex> lock(mutex);
+               if (failed)
+                  return;
+
+               inbox.swap(lp.inbox);
+               lp.floor = std::min(*lp.clock, lp.pending.empty() ? tend : lp.pending.front().time);
+               for (auto& m : inbox) // taken messages can still roll this process back
+                  lp.floor = std::min(lp.floor, m.time);
+               for (auto& q : lps)
+               {
+                  gvt = std::min(gvt, q.floor);
+                  for (auto& m : q.inbox)
+                     gvt = std::min(gvt, m.time);
+               }
+
+               if (inbox.empty() && lp.pending.empty() && *lp.clock + eps >= tend)
+               {
+                  lp.idle = true;
+                  if (std::all_of(lps.begin(), lps.end(), [](const Process& q) { return q.idle; }))
+                  {
+                     finished = true;
+                     condition.notify_all();
+                  }
+                  condition.wait(lock, [&] { return finished || failed || !lp.idle; });
+                  if (finished || failed)
+                     return;
+                  continue;
+               }
+            }
+
+            for (auto& message : inbox)
+            {
+               if (!deliver(lp, message))
+                  return fail();
+            }
+            collect(lp, gvt);
+
+            apply(lp);
+
+            const double t = *lp.clock;
+            if (t + eps < tend)
+            {
+               double target = std::min(t + window, tend);
+               if (!lp.pending.empty())
+                  target = std::min(target, lp.pending.front().time);
+
+               if (!lp.model->advanceTo(target))
+                  return fail();
+               save(lp); // before messages at target are applied
+            }
+         }
+      }
+
+      void fail()
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         failed = true;
+         condition.notify_all();
+      }
+   };
+}
\ No newline at end of file
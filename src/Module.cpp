@@ -17,14 +17,18 @@
 
 #include "ascent/Link.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace asc;
 using namespace std;
 
-std::map<std::string, Module*> ModuleCore::external;
-std::map<size_t, Module*> ModuleCore::accessor;
+ShardedMap<std::string, Module*> ModuleCore::external;
+ShardedMap<size_t, Module*> ModuleCore::accessor;
 std::map<size_t, std::unique_ptr<Simulator>> ModuleCore::simulators;
+std::mutex ModuleCore::simulators_mutex;
 
-size_t Module::next_module_id = 0;
+std::atomic<size_t> Module::next_module_id(0);
 
 struct null_deleter { void operator()(void const *) const {} };
 
@@ -36,34 +40,50 @@ void ModuleCore::error(const size_t sim, const std::string& description)
 
 Module& ModuleCore::getExternal(const std::string& name)
 {
-   return *external[name];
+   return *external.get(name);
 }
 
 Module& ModuleCore::getModule(const size_t id)
 {
-   return *accessor[id];
+   return *accessor.get(id);
 }
 
 Simulator& ModuleCore::getSimulator(const size_t sim)
 {
-   if (!simulators.count(sim))
-      simulators.emplace(sim, std::make_unique<Simulator>(sim));
+   std::lock_guard<std::mutex> lock(simulators_mutex);
+
+   auto& simulator = simulators[sim];
+   if (!simulator)
+      simulator = std::make_unique<Simulator>(sim);
 
-   return *simulators[sim];
+   return *simulator;
+}
+
+void ModuleCore::eraseSimulator(const size_t sim)
+{
+   std::unique_ptr<Simulator> simulator; // destroyed after unlocking
+
+   std::lock_guard<std::mutex> lock(simulators_mutex);
+   auto it = simulators.find(sim);
+   if (it != simulators.end())
+   {
+      simulator = std::move(it->second);
+      simulators.erase(it);
+   }
 }
 
 // Module
 Module::Module(size_t sim) : simulator(getSimulator(sim)),
    t(simulator.t), dt(simulator.dt),
    sim(sim),
-   module_id(next_module_id),
+   module_id(next_module_id++),
+   local_id(simulator.modules_created++),
    chai(simulator.chai),
    myself(this, null_deleter()),
    vars(simulator),
    external(ModuleCore::external)
 {
-   ++next_module_id;
-   ModuleCore::accessor[module_id] = this;
+   ModuleCore::accessor.set(module_id, this);
 
    simulator.modules[module_id] = this;
    
@@ -89,7 +109,23 @@ Module::~Module()
 
    ModuleCore::accessor.erase(module_id);
 
-   if (ModuleCore::external.count(module_name))
+   for (size_t id : triggers)
+      simulator.scheduler.remove(id);
+
+   forgetWaker();
+   if (sleep_pending)
+      simulator.to_sleep.erase(std::remove(simulator.to_sleep.begin(), simulator.to_sleep.end(), this), simulator.to_sleep.end());
+   if (wake_pending)
+      simulator.to_wake.erase(std::remove(simulator.to_wake.begin(), simulator.to_wake.end(), this), simulator.to_wake.end());
+
+   if (is_discrete)
+   {
+      simulator.discretes.erase(discrete_trigger.id);
+      simulator.due.erase(std::remove(simulator.due.begin(), simulator.due.end(), this), simulator.due.end());
+      simulator.discrete_resets.erase(std::remove(simulator.discrete_resets.begin(), simulator.discrete_resets.end(), this), simulator.discrete_resets.end());
+   }
+
+   if (ModuleCore::external.get(module_name) == this)
       ModuleCore::external.erase(module_name);
 
    // Pointers shouldn't be deleted because they are to this class:
@@ -121,11 +157,17 @@ Module::~Module()
    if (simulator.propagate.count(module_id))
       simulator.propagate.directErase(module_id);
 
+   for (auto& group : simulator.groups)
+   {
+      if (group->propagate.count(module_id))
+         group->propagate.directErase(module_id);
+   }
+
    if (simulator.trackers.count(module_id))
       simulator.trackers.directErase(module_id);
 
    if (simulator.modules.size() == 0) // erase the simulator if there are no more modules
-      ModuleCore::simulators.erase(sim);
+      ModuleCore::eraseSimulator(sim);
 }
 
 std::string Module::name() const
@@ -136,19 +178,253 @@ std::string Module::name() const
    return module_name;
 }
 
+Trigger Module::addSample(const double sdt)
+{
+   if (sdt <= 0.0)
+   {
+      error("Module::addSample - the sampling rate of module " + name() + " must be positive.");
+      return Trigger();
+   }
+
+   Trigger trigger = simulator.scheduler.sample(sdt, simulator.t, simulator.EPS);
+   triggers.push_back(trigger.id);
+   return trigger;
+}
+
+void Module::discrete(const double sdt)
+{
+   if (is_discrete)
+   {
+      sampleRate(discrete_trigger, sdt);
+      return;
+   }
+
+   discrete_trigger = addSample(sdt);
+   if (simulator.error)
+      return;
+
+   is_discrete = true;
+   simulator.discretes[discrete_trigger.id] = this;
+
+   // discrete modules are called through the simulator's due modules instead
+   simulator.updates.erase(module_id);
+   simulator.postcalcs.erase(module_id);
+   simulator.resets.erase(module_id);
+}
+
+void Module::addInput(const unsigned char* data, const size_t size)
+{
+   inputs.push_back(Input{ data, size, seen[0].size() });
+   for (auto& values : seen)
+      values.resize(values.size() + size);
+   seen_valid[0] = seen_valid[1] = false;
+}
+
+bool Module::inputsChanged(const size_t phase)
+{
+   if (inputs.empty())
+      return true;
+
+   ++input_checks[phase];
+
+   bool changed = !seen_valid[phase] || simulator.tickfirst || simulator.ticklast;
+   unsigned char* values = seen[phase].data();
+   for (const Input& in : inputs)
+   {
+      if (memcmp(in.data, values + in.offset, in.size) != 0)
+      {
+         memcpy(values + in.offset, in.data, in.size);
+         changed = true;
+      }
+   }
+   seen_valid[phase] = true;
+
+   if (!changed)
+      ++input_skips[phase];
+   return changed;
+}
+
+void Module::sleep()
+{
+   forgetWaker();
+   fallAsleep();
+}
+
+void Module::sleep(const double t_wake)
+{
+   const bool registered = wake_timer.valid();
+   wake_timer = simulator.scheduler.reschedule(wake_timer, t_wake);
+   if (!registered)
+      triggers.push_back(wake_timer.id);
+   sleep(wake_timer);
+}
+
+void Module::sleep(const Trigger& trigger)
+{
+   if (!trigger.valid())
+   {
+      error("Module::sleep - module " + name() + " can't sleep until an unregistered trigger.");
+      return;
+   }
+
+   forgetWaker();
+   simulator.wakers.emplace(trigger.id, this);
+   wake_on = trigger.id;
+   fallAsleep();
+}
+
+void Module::fallAsleep()
+{
+   if (wake_pending)
+   {
+      auto& to_wake = simulator.to_wake;
+      to_wake.erase(std::remove(to_wake.begin(), to_wake.end(), this), to_wake.end());
+      wake_pending = false;
+   }
+
+   if (!sleeping && !sleep_pending)
+   {
+      simulator.to_sleep.push_back(this);
+      sleep_pending = true;
+   }
+}
+
+void Module::wake()
+{
+   if (sleep_pending)
+   {
+      auto& to_sleep = simulator.to_sleep;
+      to_sleep.erase(std::remove(to_sleep.begin(), to_sleep.end(), this), to_sleep.end());
+      sleep_pending = false;
+   }
+
+   if (sleeping && !wake_pending)
+   {
+      simulator.to_wake.push_back(this);
+      wake_pending = true;
+   }
+}
+
+void Module::forgetWaker()
+{
+   if (wake_on == std::numeric_limits<size_t>::max())
+      return;
+
+   auto range = simulator.wakers.equal_range(wake_on);
+   for (auto it = range.first; it != range.second; ++it)
+   {
+      if (it->second == this)
+      {
+         simulator.wakers.erase(it);
+         break;
+      }
+   }
+   wake_on = std::numeric_limits<size_t>::max();
+}
+
+Trigger Module::addEvent(const double t_event)
+{
+   Trigger trigger = simulator.scheduler.event(t_event);
+   triggers.push_back(trigger.id);
+   return trigger;
+}
+
+Random& Module::random()
+{
+   if (!rng || rng_seed != simulator.random_seed || rng_key != simulator.random_key)
+   {
+      rng = std::make_unique<Random>(simulator.random_seed, simulator.random_key, static_cast<uint32_t>(local_id));
+      rng_seed = simulator.random_seed;
+      rng_key = simulator.random_key;
+   }
+
+   rng->seek(simulator.step_index);
+   return *rng;
+}
+
+std::vector<Link<Module>> Module::fork(const std::function<Link<Module>(const size_t sim)>& factory, const std::vector<size_t>& sims)
+{
+   return simulator.fork(factory, sims);
+}
+
 void Module::addIntegrator(double &x, double &xd, const double tolerance)
 {
-   if (!simulator.propagate.count(module_id)) // if no integrators have been added (i.e. this module hasn't been added to be propagated)
-      simulator.propagate[module_id] = this;
+   addState(x, xd, tolerance);
+}
 
-   states.push_back(simulator.integrator->factory(x, xd));
-   states.back()->tolerance = tolerance;
+void Module::addIntegrator(float &x, float &xd, const double tolerance)
+{
+   addState(x, xd, tolerance);
 }
 
-void Module::propagateStates()
+void Module::addIntegrator(long double &x, long double &xd, const double tolerance)
 {
-   for (State* state : states)
+   addState(x, xd, tolerance);
+}
+
+void Module::addIntegrator(Lanes &x, Lanes &xd, const double tolerance)
+{
+   lane_states.push_back(LaneState{ &x, &xd, integrator_group, x });
+   addState(x, xd, tolerance);
+}
+
+template <typename T>
+void Module::addState(T &x, T &xd, const double tolerance)
+{
+   State* state = nullptr;
+   if (0 == integrator_group)
+   {
+      if (!simulator.propagate.count(module_id)) // if no integrators have been added (i.e. this module hasn't been added to be propagated)
+         simulator.propagate[module_id] = this;
+
+      state = simulator.integrator->factory(x, xd);
+   }
+   else
+   {
+      IntegratorGroup& group = *simulator.groups[integrator_group - 1];
+      if (!group.propagate.count(module_id))
+         group.propagate[module_id] = this;
+
+      state = group.integrator->factory(x, xd);
+   }
+
+   if (!state)
+   {
+      simulator.setError("Module::addIntegrator - the integrator of module " + name() + " does not support this state type (lanes require a fixed step integrator).");
+      return;
+   }
+
+   states.push_back(state);
+   state->tolerance = tolerance;
+
+   if (group_states.size() <= integrator_group)
+      group_states.resize(integrator_group + 1);
+   group_states[integrator_group].push_back(states.back());
+}
+
+void Module::propagateStates(const size_t group)
+{
+   const bool masked = stop_lanes.any();
+   if (masked && simulator.kpass == 0)
+   {
+      for (auto& s : lane_states)
+      {
+         if (s.group == group)
+            s.held = *s.x;
+      }
+   }
+
+   for (State* state : group_states[group])
       state->propagate();
+
+   if (masked) // multistep integrators would move a state with a zero derivative, so stopped lanes are reset to their held values
+   {
+      for (auto& s : lane_states)
+      {
+         if (s.group == group)
+            *s.x = stop_lanes.select(s.held, *s.x);
+      }
+   }
 }
 
 void Module::callInit()
@@ -182,6 +458,9 @@ void Module::callUpdate()
       {
          if (auto ptr = p.second.lock()) // auto& not supported by Xcode libc++ compiler when last tested
          {
+            if (ptr->dormant())
+               continue; // a discrete module between its sample times doesn't run, so it doesn't hold this module back
+
             // If the run_first map contains an updating module, then we shouldn't update this module yet.
             if (ptr->update_called)
                update_now = false;
@@ -209,7 +488,19 @@ void Module::callUpdate()
          update_called = true;
 
          if (!frozen)
-            update();
+         {
+            if (fidelity_tier == 0)
+               update();
+            else if (fidelity_tiers[fidelity_tier - 1])
+               fidelity_tiers[fidelity_tier - 1]();
+
+            if (stop_lanes.any())
+            {
+               const LaneMask active = !stop_lanes;
+               for (auto& s : lane_states)
+                  mask(*s.xd, active);
+            }
+         }
          update_run = true;
          update_called = false;
       }
@@ -226,6 +517,9 @@ void Module::callPostCalc()
       {
          if (auto ptr = p.second.lock()) // auto& not supported by Xcode libc++ compiler when last tested
          {
+            if (ptr->dormant())
+               continue; // a discrete module between its sample times doesn't run, so it doesn't hold this module back
+
             if (ptr->postcalc_called)
                postcalc_now = false;
             else if (!ptr->postcalc_run)
@@ -251,7 +545,7 @@ void Module::callPostCalc()
 
          postcalc_called = true;
 
-         if (!frozen)
+         if (!frozen && (fidelity_tier == 0 || fidelity_tiers[fidelity_tier - 1]) && inputsChanged(0))
             postcalc();
          postcalc_run = true;
          postcalc_called = false;
@@ -273,7 +567,11 @@ void Module::callCheck()
 
       check_called = true;
       if (!frozen)
+      {
          check();
+         if (!lane_states.empty() && stop_lanes.all())
+            stop = true;
+      }
       check_run = true;
       check_called = false;
    }
@@ -292,7 +590,7 @@ void Module::callReport()
       }
 
       report_called = true;
-      if (!frozen)
+      if (!frozen && inputsChanged(1))
          report();
       report_run = true;
       report_called = false;
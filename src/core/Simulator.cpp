@@ -14,23 +14,38 @@
 
 #include "ascent/core/Simulator.h"
 
+#include "ascent/Link.h"
 #include "ascent/Module.h"
 #include "ascent/integrators/RK4.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 
 using namespace asc;
-
-std::map<std::string, std::shared_ptr<Module>> Simulator::tracking;
-
 using namespace std;
 
-Simulator::Simulator(size_t sim) : sim(sim), stepper(EPS, dtp, dt, t, t1, kpass, integrator_initialized)
+Simulator::Simulator(size_t sim) : sim(sim), stepper(EPS, dtp, dt, t, t1, kpass, integrator_initialized), random_key(sim)
 {
    integrator = std::make_unique<RK4>(stepper);
+   make_integrator = [](Stepper& stepper) -> std::unique_ptr<State> { return std::make_unique<RK4>(stepper); };
 }
 
 bool Simulator::run(const double dt, const double tmax)
+{
+   if (begin(dt, tmax))
+   {
+      while (!error && !ticklast)
+         pass();
+   }
+
+   return finish();
+}
+
+bool Simulator::begin(const double dt, const double tmax)
 {
    tend = tmax;
 
@@ -47,85 +62,704 @@ bool Simulator::run(const double dt, const double tmax)
       init();
    }
 
-   while (!error)
+   stepping = !error;
+   return !error;
+}
+
+bool Simulator::step(const size_t n)
+{
+   if (!stepping)
+      return setError("Simulator::step - begin() must be called before stepping the simulation.");
+
+   for (size_t i = 0; i < n && !error && !ticklast; ++i)
    {
-      event(tend);
+      while (!pass() && !error) {}
+   }
+
+   return !error;
+}
 
-      if (tickfirst)
+bool Simulator::advanceTo(const double t_target)
+{
+   if (!stepping)
+      return setError("Simulator::advanceTo - begin() must be called before stepping the simulation.");
+
+   horizon = t_target; // quiescent jumps stop at the target time
+   while (!error && !ticklast && t + EPS < t_target)
+   {
+      event(t_target); // land on the target time
+      while (!pass() && !error) {}
+   }
+   horizon = std::numeric_limits<double>::infinity();
+
+   return !error;
+}
+
+bool Simulator::end()
+{
+   if (stepping && !ticklast && !error)
+      createFiles(); // the run didn't reach tend or a stopper, so the last report has already been made without ticklast
+
+   return finish();
+}
+
+bool Simulator::pass()
+{
+   event(tend);
+
+   double t_next = std::numeric_limits<double>::infinity(); // next scheduled sample rate or event
+   if (sample())
+   {
+      if (!scheduler.empty())
       {
-         if (tick0 && track_time) // If the very first tick of the simulation.
-            t_hist.push_back(t);
+         t_next = fire();
+         event(t_next); // step no further than the next sample rate or event
+      }
+
+      if (!to_wake.empty())
+         wakeModules();
+   }
 
-         changeTimeStep();
-         report();
+   if (tickfirst)
+   {
+      if (tick0 && track_time) // If the very first tick of the simulation.
+         t_hist.push_back(t);
 
-         if (tick0) // tracker() must run after report(), but t_hist must be recorded before rpt(), thus tick0 checks are separated.
-         {
-            tracker();
-            tick0 = false;
-         }
+      changeTimeStep();
+      report();
+
+      if (tick0) // tracker() must run after report(), but t_hist must be recorded before rpt(), thus tick0 checks are separated.
+      {
+         tracker();
+         tick0 = false;
       }
+   }
+
+   if (kpass == 0) // beginning of a full step
+   {
+      if (jump_quiescent && !probing && !integrator->adaptive() && !integrator->adaptiveFSAL() && quiescent()) // adaptive steppers would grow the time step from the jump
+         jump(t_next);
+
+      ++step_index;
+   }
+
+   update();
+
+   scheduler.clear();
+   due.clear();
+
+   tickfirst = false;
+
+   if (sample())
+   {
+      if (integrator->adaptiveFSAL() && integrator_initialized)
+         adaptiveCalc();
+   }
+
+   propagateStates();
+   updateClock();
+   if (!groups.empty())
+      holdGroups();
+
+   if (sample())
+   {
+      if (track_time)
+         t_hist.push_back(t);
+
+      if (!scheduler.empty())
+         fire(); // for the end of this time step (postcalc(), check() and report()) and the first pass of the next
+
+      postcalc();
+
+      check();
+
+      runStoppers();
+
+      if (stop_simulation || (t + EPS >= tend))
+         ticklast = true;
+
+      report();
+
+      tracker();
+
+      if (integrator->adaptive())
+         adaptiveCalc();
+
+      changeTimeStep();
+
+      deleteModules();
 
-      update();
+      if (checkpoint_interval > 0.0 && t + EPS >= checkpoint_next)
+         periodicCheckpoint();
 
-      tickfirst = false;
+      if (ticklast)
+         createFiles();
+      else
+         reset();
+
+      if (!to_sleep.empty())
+         sleepModules(); // after reset(), so that a module falling asleep still runs the reset() of its last step
+      return true;
+   }
+
+   reset();
+   return false;
+}
+
+bool Simulator::finish()
+{
+   stepping = false;
+
+   directErase(true); // Specify that all DynamicMaps should use direct erasing since the simulation finished.
+
+   phase = Phase::setup;
+
+   if (error)
+   {
+      cerr << "Simulation was stopped due to an ERROR." << '\n';
+      return false;
+   }
+   return true;
+}
+
+std::vector<StepAdvice> Simulator::advise(const double dt, const double tolerance, const bool apply)
+{
+   std::vector<StepAdvice> advice;
+
+   if (modules.size() == 0)
+      setError("There are no modules to analyze.");
+
+   if (!error)
+   {
+      setup(dt);
+
+      init();
+   }
+
+   if (!error)
+   {
+      StepAdvisor advisor(*this);
+      advice = advisor.advise(dt, tolerance);
 
-      if (sample())
+      if (apply)
       {
-         if (integrator->adaptiveFSAL() && integrator_initialized)
-            adaptiveCalc();
+         for (auto& a : advice)
+         {
+            if (a.type == typeid(*integrator) && std::isfinite(a.dt()))
+            {
+               dt_change = std::min(0.9 * a.dt_stable, a.dt_accurate); // keep a margin from the stability boundary
+               change_dt = true;
+            }
+         }
       }
+   }
+
+   directErase(true);
+
+   phase = Phase::setup;
 
-      propagateStates();
-      updateClock();
+   return advice;
+}
 
-      if (sample())
+void Simulator::clearHistories()
+{
+   t_hist.clear();
+   for (auto& p : modules)
+      p.second->vars.clearHistories();
+}
+
+std::vector<double> Simulator::captureStates()
+{
+   std::vector<double> x;
+   for (auto& p : modules)
+   {
+      for (State* state : p.second->states)
+         state->capture(x);
+      p.second->captureValues(x);
+   }
+   return x;
+}
+
+bool Simulator::seedStates(const std::vector<double>& x, const double t)
+{
+   // Modules are initialized first, so that init() methods don't overwrite the seeded states.
+   directErase(false); // callInit() erases modules from inits while they are iterated
+   init();
+   directErase(true);
+   phase = Phase::setup;
+
+   const size_t n = captureStates().size();
+   if (n != x.size())
+      return setError("seedStates: " + to_string(x.size()) + " values were given for " + to_string(n) + " state values.");
+
+   size_t i = 0;
+   for (auto& p : modules)
+   {
+      for (State* state : p.second->states)
       {
-         if (track_time)
-            t_hist.push_back(t);
+         state->seed(&x[i]);
+         i += state->width();
+      }
+      i = p.second->seedValues(x, i);
+   }
 
-         postcalc();
+   this->t = t;
+   kpass = 0;
+   integrator_initialized = false; // multi-step and FSAL integrators must restart from the seeded states
 
-         check();
+   return !error;
+}
 
-         runStoppers();
+namespace
+{
+   const std::string checkpoint_magic = "ASCENT_CHECKPOINT_8";
 
-         if (stop_simulation || (t + EPS >= tend))
-            ticklast = true;
+   // Checkpoint sections are written as sized blocks, so that a mismatch is detected rather than misreading the rest of the stream.
+   template <typename Function>
+   bool writeBlock(std::ostream& stream, Function f)
+   {
+      std::ostringstream block;
+      f(block);
+      return Binary::write(stream, block.str());
+   }
 
-         report();
+   bool readBlock(std::istream& stream, std::istringstream& block)
+   {
+      std::string data;
+      if (!Binary::read(stream, data))
+         return false;
+      block.str(data);
+      return true;
+   }
+}
 
-         tracker();
+bool Simulator::checkpoint(std::ostream& stream, const bool histories)
+{
+   Binary::write(stream, checkpoint_magic, histories);
+
+   // clock
+   Binary::write(stream, EPS, dtp, dt, dt_change, change_dt, t, t1, tend, kpass, integrator_initialized, step_index, random_seed, random_key);
+   Binary::write(stream, tickfirst, tick0, ticklast, time_advanced, track_time);
+   Binary::write(stream, resolution, tick, tick1, dtp_ticks); // exact time base
+   if (histories)
+      Binary::write(stream, t_hist);
+   else
+      Binary::write(stream, static_cast<uint64_t>(t_hist.size()));
 
-         if (integrator->adaptive())
-            adaptiveCalc();
+   Binary::write(stream, std::string(typeid(*integrator).name()));
+   writeBlock(stream, [&](std::ostream& s) { integrator->saveIntegrator(s); });
 
-         changeTimeStep();
+   Binary::write(stream, static_cast<uint64_t>(groups.size()));
+   for (auto& group : groups)
+   {
+      Binary::write(stream, std::string(group->type.name()), group->t, group->t1, group->kpass, group->integrator_initialized, group->active);
+      writeBlock(stream, [&](std::ostream& s) { group->integrator->saveIntegrator(s); });
+   }
 
-         deleteModules();
+   writeBlock(stream, [&](std::ostream& s) { scheduler.save(s); });
 
-         if (ticklast)
+   std::vector<uint64_t> demotions; // demoted modules by position, since module ids differ between simulators
+   for (size_t id : demoted)
+   {
+      uint64_t position = 0;
+      for (auto& p : modules)
+      {
+         if (p.first == id)
          {
-            createFiles();
+            demotions.push_back(position);
             break;
          }
+         ++position;
+      }
+   }
+   Binary::write(stream, demotions);
+
+   Binary::write(stream, static_cast<uint64_t>(modules.size()));
+   for (auto& p : modules)
+   {
+      Module& module = *p.second;
+      Binary::write(stream, std::string(typeid(module).name()), module.init_run);
+      writeBlock(stream, [&](std::ostream& s) { saveFlags(s, module); });
+
+      Binary::write(stream, static_cast<uint64_t>(module.states.size()));
+      for (State* state : module.states)
+         writeBlock(stream, [&](std::ostream& s) { state->save(s); });
+
+      auto names = module.vars.getNames();
+      Binary::write(stream, static_cast<uint64_t>(names.size()));
+      for (auto& name : names)
+      {
+         bool supported = true;
+         Binary::write(stream, name.second);
+         writeBlock(stream, [&](std::ostream& s) { supported = histories ? module.vars.save(name.second, s) : module.vars.mark(name.second, s); });
+         Binary::write(stream, supported); // unsupported types are skipped when restoring
       }
 
-      reset();
+      writeBlock(stream, [&](std::ostream& s) { module.checkpoint(s); });
    }
-   
-   directErase(true); // Specify that all DynamicMaps should use direct erasing since the simulation finished.
 
-   phase = Phase::setup;
+   if (!stream.good())
+      return setError("checkpoint: The checkpoint could not be written.");
+   return true;
+}
 
-   if (error)
+bool Simulator::restore(std::istream& stream)
+{
+   const std::string mismatch = "restore: The checkpoint doesn't match this simulator's ";
+
+   std::string magic;
+   bool histories{};
+   if (!Binary::read(stream, magic) || magic != checkpoint_magic || !Binary::read(stream, histories))
+      return setError("restore: The stream isn't an Ascent checkpoint.");
+
+   if (!Binary::read(stream, EPS, dtp, dt, dt_change, change_dt, t, t1, tend, kpass, integrator_initialized, step_index, random_seed, random_key) ||
+      !Binary::read(stream, tickfirst, tick0, ticklast, time_advanced, track_time))
+      return setError("restore: The checkpoint's clock couldn't be read.");
+   if (!Binary::read(stream, resolution, tick, tick1, dtp_ticks))
+      return setError(mismatch + "time base.");
+   scheduler.resolution = resolution;
+
+   size_t dropped = 0; // steps recorded since a checkpoint without histories
+   if (histories)
    {
-      cerr << "Simulation was stopped due to an ERROR." << '\n';
-      return false;
+      if (!Binary::read(stream, t_hist))
+         return setError("restore: The checkpoint's time history couldn't be read.");
+   }
+   else
+   {
+      uint64_t length{};
+      if (!Binary::read(stream, length) || length > t_hist.size())
+         return setError("restore: A checkpoint without histories can only roll back the simulator that wrote it.");
+      dropped = t_hist.size() - static_cast<size_t>(length);
+      t_hist.resize(static_cast<size_t>(length));
+   }
+
+   std::string type;
+   std::istringstream block;
+   if (!Binary::read(stream, type) || type != typeid(*integrator).name())
+      return setError(mismatch + "integrator.");
+   if (!readBlock(stream, block) || !integrator->loadIntegrator(block))
+      return setError(mismatch + "integrator data.");
+
+   uint64_t n{};
+   if (!Binary::read(stream, n) || n != groups.size())
+      return setError(mismatch + "integrator groups.");
+   for (auto& group : groups)
+   {
+      if (!Binary::read(stream, type) || type != group->type.name())
+         return setError(mismatch + "integrator groups.");
+      Binary::read(stream, group->t, group->t1, group->kpass, group->integrator_initialized, group->active);
+      if (!readBlock(stream, block) || !group->integrator->loadIntegrator(block))
+         return setError(mismatch + "integrator group data.");
    }
+
+   if (!readBlock(stream, block) || !scheduler.load(block))
+      return setError(mismatch + "scheduled sample rates and events.");
+
+   std::vector<uint64_t> demotions;
+   if (!Binary::read(stream, demotions))
+      return setError(mismatch + "fidelity demotions.");
+
+   if (!Binary::read(stream, n) || n != modules.size())
+      return setError(mismatch + "number of modules.");
+
+   demoted.clear();
+   std::vector<size_t> ids;
+   for (auto& p : modules)
+      ids.push_back(p.first);
+   for (uint64_t position : demotions)
+   {
+      if (position >= ids.size())
+         return setError(mismatch + "fidelity demotions.");
+      demoted.push_back(ids[position]);
+   }
+
+   for (auto& p : modules)
+   {
+      Module& module = *p.second;
+      bool init_run{};
+      if (!Binary::read(stream, type) || type != typeid(module).name())
+         return setError(mismatch + "modules, expected <" + typeid(module).name() + "> but found <" + type + ">.");
+      Binary::read(stream, init_run);
+
+      if (!readBlock(stream, block) || !loadFlags(block, module))
+         return setError(mismatch + "flags of module <" + type + ">.");
+
+      if (init_run) // skip initialization, init() would overwrite the restored data
+      {
+         module.init_run = true;
+         if (inits.count(module.module_id))
+            inits.directErase(module.module_id);
+      }
+
+      if (!Binary::read(stream, n) || n != module.states.size())
+         return setError(mismatch + "states of module <" + type + ">.");
+      for (State* state : module.states)
+      {
+         if (!readBlock(stream, block) || !state->load(block))
+            return setError(mismatch + "states of module <" + type + ">.");
+      }
+
+      if (!Binary::read(stream, n))
+         return setError(mismatch + "variables of module <" + type + ">.");
+      for (uint64_t i = 0; i < n; ++i)
+      {
+         std::string id;
+         bool supported{};
+         Binary::read(stream, id);
+         const bool read = readBlock(stream, block);
+         if (!read || !Binary::read(stream, supported))
+            return setError(mismatch + "variables of module <" + type + ">.");
+         if (supported && !(histories ? module.vars.load(id, block) : module.vars.rewind(id, block, dropped)))
+            return setError(mismatch + "variable <" + id + "> of module <" + type + ">.");
+      }
+
+      if (!readBlock(stream, block) || !module.restore(block))
+         return setError(mismatch + "data of module <" + type + ">.");
+   }
+
+   return !error;
+}
+
+void Simulator::saveFlags(std::ostream& stream, const Module& module) const
+{
+   Binary::write(stream, module.frozen, module.freeze_integration, module.stop, module.stop_lanes, static_cast<uint64_t>(module.fidelity_tier));
+   Binary::write(stream, module.sleeping, module.sleep_pending, module.wake_pending, static_cast<uint64_t>(module.wake_timer.valid() ? module.wake_timer.id + 1 : 0), static_cast<uint64_t>(module.wake_on));
+}
+
+bool Simulator::loadFlags(std::istream& stream, Module& module)
+{
+   uint64_t fidelity_tier{};
+   bool sleeping{}, sleep_pending{}, wake_pending{};
+   uint64_t wake_timer{}, wake_on{};
+   if (!Binary::read(stream, module.frozen, module.freeze_integration, module.stop, module.stop_lanes, fidelity_tier) || !Binary::read(stream, sleeping, sleep_pending, wake_pending, wake_timer, wake_on))
+      return false;
+
+   module.fidelity_tier = std::min(static_cast<size_t>(fidelity_tier), module.fidelity_tiers.size());
+   restoreSleep(module, sleeping, sleep_pending, wake_pending, wake_timer, wake_on);
    return true;
 }
 
+bool Simulator::checkpoint(const std::string& file)
+{
+   std::ofstream stream(file, std::ios::binary);
+   if (!stream)
+      return setError("checkpoint: The file <" + file + "> could not be opened.");
+   return checkpoint(static_cast<std::ostream&>(stream));
+}
+
+bool Simulator::restore(const std::string& file)
+{
+   std::ifstream stream(file, std::ios::binary);
+   if (!stream)
+      return setError("restore: The file <" + file + "> could not be opened.");
+   return restore(static_cast<std::istream&>(stream));
+}
+
+void Simulator::checkpointEvery(const double interval, const std::string& file)
+{
+   checkpoint_interval = interval;
+   checkpoint_file = file;
+   checkpoint_next = t + interval;
+}
+
+void Simulator::periodicCheckpoint()
+{
+   if (checkpoint_write.valid())
+   {
+      if (checkpoint_write.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      {
+         ++checkpoints_skipped; // the previous checkpoint is still being written
+         checkpoint_next = t + checkpoint_interval;
+         return;
+      }
+
+      if (!checkpoint_write.get())
+         setError("checkpoint: The file <" + checkpoint_file + "> could not be written.");
+   }
+
+   // The snapshot is taken in memory here, only the file output is asynchronous.
+   std::ostringstream snapshot;
+   if (!checkpoint(snapshot))
+      return;
+
+   checkpoint_write = std::async(std::launch::async, [file = checkpoint_file, data = snapshot.str()]()
+   {
+      // Write to a temporary file first, so that a crash while writing doesn't destroy the previous checkpoint.
+      const std::string temporary = file + ".tmp";
+      {
+         std::ofstream stream(temporary, std::ios::binary);
+         stream.write(data.data(), data.size());
+         if (!stream)
+            return false;
+      }
+
+      if (std::rename(temporary.c_str(), file.c_str()) != 0)
+      {
+         std::remove(file.c_str()); // rename doesn't replace existing files on every platform
+         return std::rename(temporary.c_str(), file.c_str()) == 0;
+      }
+      return true;
+   });
+
+   ++checkpoints_written;
+   checkpoint_next = t + checkpoint_interval;
+}
+
+std::vector<Link<Module>> Simulator::fork(const std::function<Link<Module>(const size_t sim)>& factory, const std::vector<size_t>& sims)
+{
+   std::vector<Link<Module>> branches;
+
+   std::stringstream snapshot;
+   if (!checkpoint(snapshot))
+      return branches;
+   const std::string data = snapshot.str();
+
+   for (const size_t id : sims)
+   {
+      Simulator& branch = Module::getSimulator(id);
+      if (&branch == this || branch.propagate.size() > 0)
+      {
+         setError("fork: Simulator " + to_string(id) + " already has states.");
+         return {};
+      }
+
+      branch.integrator = make_integrator(branch.stepper);
+      branch.make_integrator = make_integrator;
+
+      branches.push_back(factory(id));
+
+      std::istringstream stream(data);
+      if (!branch.restore(stream))
+      {
+         setError("fork: Simulator " + to_string(id) + " could not be restored, its model must be built as this simulator's model.");
+         return {};
+      }
+   }
+
+   return branches;
+}
+
+bool Simulator::snapshot()
+{
+   if (inits.size() > 0)
+   {
+      directErase(false);
+      init();
+      directErase(true);
+      phase = Phase::setup;
+   }
+
+   if (error)
+      return false;
+
+   snapshot_modules.clear();
+   snapshot_restores.clear();
+
+   // Copies are captured by the closures, so restoring only assigns (reusing memory) rather than constructing.
+   snapshot_restores.push_back([this, EPS = EPS, dtp = dtp, dt = dt, dt_change = dt_change, change_dt = change_dt, t = t, t1 = t1, tend = tend, kpass = kpass,
+      integrator_initialized = integrator_initialized, step_index = step_index, tickfirst = tickfirst, tick0 = tick0, ticklast = ticklast, track_time = track_time, t_hist = t_hist,
+      resolution = resolution, tick = tick, tick1 = tick1, dtp_ticks = dtp_ticks]()
+   {
+      this->EPS = EPS; this->dtp = dtp; this->dt = dt; this->dt_change = dt_change; this->change_dt = change_dt;
+      this->t = t; this->t1 = t1; this->tend = tend; this->kpass = kpass; this->integrator_initialized = integrator_initialized; this->step_index = step_index;
+      this->tickfirst = tickfirst; this->tick0 = tick0; this->ticklast = ticklast; this->track_time = track_time; this->t_hist = t_hist;
+      this->resolution = resolution; this->tick = tick; this->tick1 = tick1; this->dtp_ticks = dtp_ticks; scheduler.resolution = resolution;
+      stop_simulation = false;
+      error = false; // errors of the previous run don't carry over
+      error_descriptions.clear();
+   });
+
+   // States and integrator internals are restored through their checkpoint methods.
+   auto saved = [](auto save)
+   {
+      std::ostringstream stream;
+      save(stream);
+      return stream.str();
+   };
+
+   State* prototype = integrator.get();
+   snapshot_restores.push_back([prototype, data = saved([&](std::ostream& s) { prototype->saveIntegrator(s); })]()
+   {
+      std::istringstream stream(data);
+      prototype->loadIntegrator(stream);
+   });
+
+   snapshot_restores.push_back([this, data = saved([&](std::ostream& s) { scheduler.save(s); })]()
+   {
+      std::istringstream stream(data);
+      scheduler.load(stream);
+   });
+
+   for (auto& group : groups)
+   {
+      IntegratorGroup* g = group.get();
+      snapshot_restores.push_back([g, t = g->t, t1 = g->t1, kpass = g->kpass, initialized = g->integrator_initialized, active = g->active,
+         data = saved([&](std::ostream& s) { g->integrator->saveIntegrator(s); })]()
+      {
+         g->t = t; g->t1 = t1; g->kpass = kpass; g->integrator_initialized = initialized; g->active = active;
+         std::istringstream stream(data);
+         g->integrator->loadIntegrator(stream);
+      });
+   }
+
+   snapshot_restores.push_back([this, demoted = demoted]() { this->demoted = demoted; });
+
+   for (auto& p : modules)
+   {
+      Module* module = p.second;
+      snapshot_modules.push_back(module->module_id);
+
+      snapshot_restores.push_back([this, module, data = saved([&](std::ostream& s) { saveFlags(s, *module); })]()
+      {
+         std::istringstream stream(data);
+         loadFlags(stream, *module);
+      });
+
+      for (State* state : module->states)
+      {
+         snapshot_restores.push_back([state, data = saved([&](std::ostream& s) { state->save(s); })]()
+         {
+            std::istringstream stream(data);
+            state->load(stream);
+         });
+      }
+
+      for (auto& name : module->vars.getNames())
+         snapshot_restores.push_back(module->vars.snapshot(name.second));
+
+      snapshot_restores.push_back([module, data = saved([&](std::ostream& s) { module->checkpoint(s); })]()
+      {
+         std::istringstream stream(data);
+         module->restore(stream);
+      });
+   }
+
+   return !error;
+}
+
+bool Simulator::restoreSnapshot()
+{
+   if (snapshot_restores.empty())
+      return setError("restoreSnapshot: There is no snapshot to restore.");
+
+   bool same = modules.size() == snapshot_modules.size();
+   size_t i = 0;
+   for (auto& p : modules)
+   {
+      if (!same)
+         break;
+      same = p.first == snapshot_modules[i++];
+   }
+   if (!same)
+      return setError("restoreSnapshot: Modules were created or deleted since the snapshot.");
+
+   for (auto& restore : snapshot_restores)
+      restore();
+
+   return !error;
+}
+
 void Simulator::directErase(bool b)
 {
    modules.direct_erase = b;
@@ -138,6 +772,36 @@ void Simulator::directErase(bool b)
    resets.direct_erase = b;
 
    propagate.direct_erase = b;
+
+   for (auto& group : groups)
+      group->propagate.direct_erase = b;
+}
+
+void Simulator::reserve(const size_t steps)
+{
+   if (track_time)
+      t_hist.reserve(t_hist.size() + steps);
+
+   const size_t n = modules.size();
+
+   modules.reserve(n);
+
+   inits.reserve(n);
+   updates.reserve(n);
+   postcalcs.reserve(n);
+   checks.reserve(n);
+   reports.reserve(n);
+   resets.reserve(n);
+
+   propagate.reserve(n);
+
+   for (auto& group : groups)
+      group->propagate.reserve(n);
+
+   to_delete.reserve(n);
+
+   due.reserve(discretes.size());
+   discrete_resets.reserve(discretes.size());
 }
 
 void Simulator::setup(const double dt)
@@ -149,6 +813,18 @@ void Simulator::setup(const double dt)
 
    this->dt = dtp = dt; // sets base time step (dtp) and adjustable time step (dt)
    t1 = t + dt; // sets intended end time of next timestep
+
+   if (resolution > 0.0)
+   {
+      tick = ticks(t);
+      dtp_ticks = ticks(dtp);
+      if (dtp_ticks <= 0 || fabs(dtp_ticks * resolution - dtp) > 1e-9 * dtp)
+         setError("The time step : " + to_string(dtp) + " isn't a multiple of the time base resolution : " + to_string(resolution));
+      tick1 = tick + dtp_ticks;
+      t = tick * resolution;
+      t1 = tick1 * resolution;
+      this->dt = t1 - t;
+   }
    kpass = 0;
    ticklast = false;
    tickfirst = true;
@@ -183,10 +859,22 @@ void Simulator::update()
          break;
    }
 
+   for (Module* module : due)
+   {
+      module->callUpdate();
+      discrete_resets.push_back(module);
+
+      if (error)
+         break;
+   }
+
    updates.erase();
 
    for (auto& p : updates)
       p.second->update_run = false;
+
+   for (Module* module : due)
+      module->update_run = false;
 }
 
 void Simulator::postcalc()
@@ -201,10 +889,21 @@ void Simulator::postcalc()
          break;
    }
 
+   for (Module* module : due)
+   {
+      module->callPostCalc();
+
+      if (error)
+         break;
+   }
+
    postcalcs.erase();
 
    for (auto& p : postcalcs)
       p.second->postcalc_run = false;
+
+   for (Module* module : due)
+      module->postcalc_run = false;
 }
 
 void Simulator::check()
@@ -255,10 +954,17 @@ void Simulator::reset()
          break;
    }
 
+   for (Module* module : discrete_resets)
+      module->callReset();
+
    resets.erase();
 
    for (auto& p : resets)
       p.second->reset_run = false;
+
+   for (Module* module : discrete_resets)
+      module->reset_run = false;
+   discrete_resets.clear();
 }
 
 void Simulator::tracker()
@@ -277,6 +983,85 @@ void Simulator::propagateStates()
       if (!module->frozen && !module->freeze_integration) // if neither is frozen then propagate
          module->propagateStates();
    }
+
+   // Module selected integrators are only propagated when this pass is at the time of their next stage.
+   for (auto& group : groups)
+   {
+      if (kpass == 0) // beginning of a full step
+      {
+         group->active = true;
+         group->t = t;
+         group->t1 = t1;
+         group->kpass = 0;
+         group->t_start = t;
+         group->t_end = t1;
+         groupStates(*group, group->x_start);
+      }
+
+      if (group->active && fabs(t - group->t) < EPS)
+      {
+         for (auto& p : group->propagate)
+         {
+            auto module = p.second;
+            if (!module->frozen && !module->freeze_integration)
+               module->propagateStates(group->id);
+         }
+
+         group->integrator->updateClock();
+
+         if (group->kpass == 0) // the group completed its step
+         {
+            group->active = false;
+            group->holding = true;
+            groupStates(*group, group->x_end);
+         }
+      }
+   }
+}
+
+void Simulator::holdGroups()
+{
+   for (auto& group : groups)
+   {
+      if (!group->holding)
+         continue;
+
+      if (kpass == 0) // the simulator's step completed as well
+      {
+         seedGroup(*group, group->x_end);
+         group->holding = false;
+         continue;
+      }
+
+      const double f = (t - group->t_start) / (group->t_end - group->t_start);
+      std::vector<double> x(group->x_start.size());
+      for (size_t i = 0; i < x.size(); ++i)
+         x[i] = group->x_start[i] + f * (group->x_end[i] - group->x_start[i]);
+      seedGroup(*group, x);
+   }
+}
+
+void Simulator::groupStates(IntegratorGroup& group, std::vector<double>& x)
+{
+   x.clear();
+   for (auto& p : group.propagate)
+   {
+      for (State* state : p.second->group_states[group.id])
+         state->capture(x);
+   }
+}
+
+void Simulator::seedGroup(IntegratorGroup& group, const std::vector<double>& x)
+{
+   size_t i = 0;
+   for (auto& p : group.propagate)
+   {
+      for (State* state : p.second->group_states[group.id])
+      {
+         state->seed(&x[i]);
+         i += state->width();
+      }
+   }
 }
 
 void Simulator::updateClock()
@@ -285,10 +1070,27 @@ void Simulator::updateClock()
 
    integrator->updateClock();
 
+   if (resolution > 0.0 && kpass == 0) // replace the integrator's floating point end of step
+   {
+      tick = tick1;
+      t = tick * resolution;
+      tick1 = (tick / dtp_ticks + 1) * dtp_ticks;
+      t1 = tick1 * resolution;
+   }
+
    if (t >= (t_prev + EPS))
       time_advanced = true;
    else
       time_advanced = false;
+
+   if (kpass == 0)
+   {
+      for (auto& group : groups)
+      {
+         if (group->active)
+            setError("The stage times of a module selected integrator do not align with the simulator's integrator. Select an integrator whose stage times are a subset of the simulator integrator's stage times.");
+      }
+   }
 }
 
 void Simulator::adaptiveCalc()
@@ -300,9 +1102,10 @@ void Simulator::adaptiveCalc()
       auto module = p.second;
       if (!module->frozen && !module->freeze_integration)
       {
-         for (State* state : module->states)
+         for (State* state : module->group_states[0]) // only the simulator's integrator adapts the time step
          {
             double computed = state->optimalTimeStep();
+
             if ((computed > 0.0) && (computed < dt_optimal))
             {
                dt_optimal = computed;
@@ -335,6 +1138,14 @@ void Simulator::changeTimeStep()
       dt = dtp = dt_change;
       t1 = t + dt;
       change_dt = false;
+
+      if (resolution > 0.0)
+      {
+         dtp_ticks = std::max<int64_t>(ticks(dtp), 1);
+         tick1 = tick + dtp_ticks;
+         t1 = tick1 * resolution;
+         dt = t1 - t;
+      }
    }
 }
 
@@ -358,7 +1169,7 @@ void Simulator::deleteModules()
 
 bool Simulator::sample()
 {
-   if (kpass == 0)
+   if (kpass == 0 && !probing)
       return true;
    return false;
 }
@@ -367,6 +1178,20 @@ bool Simulator::sample(double sdt) // only changes the timestep if the sample pr
 {
    if (!sample())
       return false; // if intermediate step
+
+   if (resolution > 0.0)
+   {
+      const int64_t s = std::max<int64_t>(ticks(sdt), 1);
+      const int64_t ts = (tick / s + 1) * s; // next sample time in ticks
+      if (ts < tick1)
+      {
+         tick1 = ts;
+         t1 = tick1 * resolution;
+      }
+
+      dt = t1 - t;
+      return tick % s == 0;
+   }
                     
    // calculate the end time if using the sample deltat (sdt)
    double n = floor((t + EPS) / sdt + 1); // number of sample time steps that have occurred + 1, rounded down to nearest whole number
@@ -388,6 +1213,22 @@ bool Simulator::event(double t_event)
    if (!sample())
       return false; // if intermediate step
 
+   if (resolution > 0.0)
+   {
+      if (t_event < t1 && t_event > t)
+      {
+         const int64_t te = ticks(t_event);
+         if (te < tick1 && te > tick)
+         {
+            tick1 = te;
+            t1 = tick1 * resolution;
+         }
+      }
+
+      dt = t1 - t;
+      return fabs(t_event - t) < resolution && ticks(t_event) == tick;
+   }
+
    if (t_event < t1 - EPS && t_event >= t + EPS)
       t1 = t_event;
 
@@ -404,6 +1245,255 @@ void Simulator::integrationTolerance(double tolerance) // Set global adaptive st
       p.second->integrationTolerance(tolerance);
 }
 
+double Simulator::fire()
+{
+   const size_t n = scheduler.due().size();
+   const double next = scheduler.fire(t, EPS);
+
+   const std::vector<size_t>& fired = scheduler.due();
+   for (size_t i = n; i < fired.size(); ++i)
+   {
+      auto it = discretes.find(fired[i]);
+      if (it != discretes.end() && !it->second->sleeping)
+         due.push_back(it->second);
+
+      if (!wakers.empty())
+      {
+         auto range = wakers.equal_range(fired[i]);
+         for (auto w = range.first; w != range.second; ++w)
+            w->second->wake();
+      }
+   }
+   return next;
+}
+
+void Simulator::restoreSleep(Module& module, const bool sleeping, const bool sleep_pending, const bool wake_pending, const uint64_t wake_timer, const uint64_t wake_on)
+{
+   if (module.sleep_pending)
+   {
+      to_sleep.erase(std::remove(to_sleep.begin(), to_sleep.end(), &module), to_sleep.end());
+      module.sleep_pending = false;
+   }
+   if (module.wake_pending)
+   {
+      to_wake.erase(std::remove(to_wake.begin(), to_wake.end(), &module), to_wake.end());
+      module.wake_pending = false;
+   }
+
+   if (wake_timer > 0 && !module.wake_timer.valid())
+   {
+      module.wake_timer = scheduler.trigger(static_cast<size_t>(wake_timer - 1)); // created lazily, after the checkpoint's registrations were loaded
+      module.triggers.push_back(module.wake_timer.id);
+   }
+
+   if (sleeping)
+      sleepNow(&module);
+   else
+      wakeNow(&module);
+
+   module.forgetWaker();
+   if (wake_on != std::numeric_limits<size_t>::max())
+   {
+      wakers.emplace(static_cast<size_t>(wake_on), &module);
+      module.wake_on = static_cast<size_t>(wake_on);
+   }
+
+   if (sleep_pending)
+      module.fallAsleep();
+   if (wake_pending)
+      module.wake();
+}
+
+bool Simulator::quiescent()
+{
+   if (updates.size() || postcalcs.size() || checks.size() || reports.size() || resets.size())
+      return false;
+
+   if (!due.empty() || !to_wake.empty() || !to_sleep.empty() || change_dt)
+      return false;
+
+   auto still = [](module_map& modules)
+   {
+      for (auto& p : modules)
+      {
+         Module* module = p.second;
+         if (module->frozen || module->freeze_integration)
+            continue;
+
+         for (State* state : module->states)
+         {
+            if (!state->still())
+               return false;
+         }
+      }
+      return true;
+   };
+
+   if (!still(propagate))
+      return false;
+
+   for (auto& group : groups)
+   {
+      if (!still(group->propagate))
+         return false;
+   }
+   return true;
+}
+
+void Simulator::jump(const double t_next)
+{
+   double target = std::min(std::min(t_next, tend), horizon);
+   if (checkpoint_interval > 0.0)
+      target = std::min(target, checkpoint_next);
+
+   if (target < std::numeric_limits<double>::infinity() && target > t1 + EPS)
+   {
+      t1 = target;
+      if (resolution > 0.0)
+      {
+         tick1 = ticks(target);
+         t1 = tick1 * resolution;
+      }
+      dt = t1 - t;
+      ++quiescent_jumps;
+   }
+}
+
+void Simulator::sleepModules()
+{
+   for (Module* module : to_sleep)
+   {
+      module->sleep_pending = false;
+      sleepNow(module);
+   }
+   to_sleep.clear();
+}
+
+void Simulator::wakeModules()
+{
+   for (Module* module : to_wake)
+   {
+      module->wake_pending = false;
+      wakeNow(module);
+   }
+   to_wake.clear();
+}
+
+void Simulator::sleepNow(Module* module)
+{
+   if (module->sleeping)
+      return;
+
+   const size_t id = module->module_id;
+   module_map* maps[] = { &updates, &postcalcs, &checks, &reports, &resets, &propagate };
+
+   module->sleep_phases = 0;
+   for (size_t i = 0; i < 6; ++i)
+   {
+      if (maps[i]->count(id))
+      {
+         module->sleep_phases |= 1 << i;
+         maps[i]->directErase(id); // not called while the maps are iterated
+      }
+   }
+
+   for (auto& group : groups)
+   {
+      if (group->propagate.count(id))
+         group->propagate.directErase(id);
+   }
+
+   module->sleeping = true;
+}
+
+void Simulator::wakeNow(Module* module)
+{
+   if (!module->sleeping)
+      return;
+
+   const size_t id = module->module_id;
+   module_map* maps[] = { &updates, &postcalcs, &checks, &reports, &resets, &propagate };
+
+   for (size_t i = 0; i < 6; ++i)
+   {
+      if (module->sleep_phases & (1 << i))
+         (*maps[i])[id] = module;
+   }
+
+   for (auto& group : groups)
+   {
+      if (group->id < module->group_states.size() && !module->group_states[group->id].empty())
+         group->propagate[id] = module;
+   }
+
+   module->forgetWaker();
+   module->sleeping = false;
+
+   if (module->is_discrete && module->discrete_trigger) // its sample time is now
+      due.push_back(module);
+}
+
+std::vector<SkipRate> Simulator::skipRates()
+{
+   std::vector<SkipRate> rates;
+   for (auto& p : modules)
+   {
+      const Module* module = p.second;
+      if (!module->inputs.empty())
+         rates.push_back(SkipRate{ module->name(), module->input_checks[0], module->input_skips[0], module->input_checks[1], module->input_skips[1] });
+   }
+   return rates;
+}
+
+void Simulator::timeBase(const double resolution)
+{
+   if (resolution < 0.0)
+      setError("The time base resolution : " + to_string(resolution) + " must not be negative.");
+   else
+   {
+      this->resolution = resolution;
+      scheduler.resolution = resolution;
+   }
+}
+
+Module* Simulator::demote()
+{
+   Module* module = nullptr;
+   for (auto& p : modules)
+   {
+      Module* candidate = p.second;
+      if (!candidate->frozen && candidate->fidelity_tier < candidate->fidelity_tiers.size() && (!module || candidate->fidelity_priority <= module->fidelity_priority))
+         module = candidate;
+   }
+
+   if (module)
+   {
+      ++module->fidelity_tier;
+      demoted.push_back(module->module_id);
+   }
+   return module;
+}
+
+Module* Simulator::promote()
+{
+   while (!demoted.empty())
+   {
+      const size_t id = demoted.back();
+      demoted.pop_back();
+
+      if (modules.count(id)) // modules may have been deleted since they were demoted
+      {
+         Module* module = modules[id];
+         if (module->fidelity_tier > 0)
+         {
+            --module->fidelity_tier;
+            return module;
+         }
+      }
+   }
+   return nullptr;
+}
+
 void Simulator::createFiles()
 {
    for (auto& p : tracking)
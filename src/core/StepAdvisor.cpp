@@ -0,0 +1,368 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/core/StepAdvisor.h"
+
+#include "ascent/Module.h"
+
+#include "ascent/integrators/DOPRI45.h"
+#include "ascent/integrators/DOPRI87.h"
+#include "ascent/integrators/Euler.h"
+#include "ascent/integrators/PC233.h"
+#include "ascent/integrators/RK2.h"
+#include "ascent/integrators/RK4.h"
+#include "ascent/integrators/RKMM.h"
+#include "ascent/integrators/RTAM2.h"
+#include "ascent/integrators/RTAM3.h"
+#include "ascent/integrators/RTAM4.h"
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+using namespace asc;
+using namespace std;
+
+namespace
+{
+   template <typename T>
+   unique_ptr<State> makeIntegrator(Stepper& stepper) { return make_unique<T>(stepper); }
+}
+
+vector<StepAdvisor::Candidate> StepAdvisor::candidates()
+{
+   // Adaptive integrators are included because they run with a fixed step when no state has a tolerance.
+   return {
+      { "Euler", typeid(Euler), 1, makeIntegrator<Euler> },
+      { "RK2", typeid(RK2), 2, makeIntegrator<RK2> },
+      { "RK4", typeid(RK4), 4, makeIntegrator<RK4> },
+      { "RKMM", typeid(RKMM), 4, makeIntegrator<RKMM> },
+      { "PC233", typeid(PC233), 3, makeIntegrator<PC233> },
+      { "RTAM2", typeid(RTAM2), 2, makeIntegrator<RTAM2> },
+      { "RTAM3", typeid(RTAM3), 3, makeIntegrator<RTAM3> },
+      { "RTAM4", typeid(RTAM4), 4, makeIntegrator<RTAM4> },
+      { "DOPRI45", typeid(DOPRI45), 5, makeIntegrator<DOPRI45> },
+      { "DOPRI87", typeid(DOPRI87), 8, makeIntegrator<DOPRI87> }
+   };
+}
+
+vector<StepAdvice> StepAdvisor::advise(const double dt, const double tolerance)
+{
+   vector<StepAdvice> advice;
+
+   states.clear();
+   for (auto& p : simulator.modules) // includes states of module selected integrators
+   {
+      Module* module = p.second;
+      if (!module->frozen && !module->freeze_integration)
+      {
+         for (State* state : module->states)
+            states.push_back(state);
+      }
+   }
+
+   if (states.size() == 0)
+   {
+      simulator.setError("StepAdvisor: There are no states to analyze.");
+      return advice;
+   }
+
+   // Save the simulator's states and clock so that they can be restored after the analysis.
+   const string x0 = saveStates();
+
+   const double t = simulator.t, dt_prev = simulator.dt, dtp = simulator.dtp, t1 = simulator.t1;
+   const size_t kpass = simulator.kpass;
+   const bool integrator_initialized = simulator.integrator_initialized;
+
+   simulator.probing = true;
+
+   estimateEigenvalue();
+
+   for (auto& candidate : candidates())
+   {
+      if (simulator.error)
+         break;
+
+      StepAdvice a;
+      a.integrator = candidate.name;
+      a.type = candidate.type;
+      a.dt_stable = stableStep(candidate);
+      a.dt_accurate = accurateStep(candidate, dt, tolerance);
+      advice.push_back(a);
+
+      loadStates(x0);
+   }
+
+   simulator.probing = false;
+
+   loadStates(x0);
+
+   simulator.t = t;
+   simulator.dt = dt_prev;
+   simulator.dtp = dtp;
+   simulator.t1 = t1;
+   simulator.kpass = kpass;
+   simulator.integrator_initialized = integrator_initialized;
+
+   return advice;
+}
+
+string StepAdvisor::saveStates() const
+{
+   // Complete states (i.e. every lane of lane states and integration histories), values alone only hold a state's first lane.
+   ostringstream stream;
+   for (State* state : states)
+      state->save(stream);
+   return stream.str();
+}
+
+void StepAdvisor::loadStates(const string& saved)
+{
+   istringstream stream(saved);
+   for (State* state : states)
+      state->load(stream);
+}
+
+void StepAdvisor::derivatives(std::vector<double>& xd)
+{
+   simulator.update();
+
+   xd.resize(states.size());
+   for (size_t i = 0; i < states.size(); ++i)
+      xd[i] = states[i]->derivative();
+}
+
+void StepAdvisor::estimateEigenvalue()
+{
+   const size_t n = states.size();
+
+   Eigen::VectorXd x0(n);
+   for (size_t i = 0; i < n; ++i)
+      x0(i) = states[i]->value();
+
+   vector<double> f;
+   derivatives(f);
+   const Eigen::VectorXd f0 = Eigen::Map<Eigen::VectorXd>(f.data(), n);
+
+   const double eps = sqrt(numeric_limits<double>::epsilon()) * (1.0 + x0.norm());
+
+   // Jacobian-vector product by a forward difference, v must be normalized
+   auto jacobian = [&](const Eigen::VectorXd& v) -> Eigen::VectorXd
+   {
+      for (size_t i = 0; i < n; ++i)
+         states[i]->value(x0(i) + eps * v(i));
+
+      derivatives(f);
+
+      for (size_t i = 0; i < n; ++i)
+         states[i]->value(x0(i));
+
+      return (Eigen::Map<Eigen::VectorXd>(f.data(), n) - f0) / eps;
+   };
+
+   Eigen::VectorXd v(n);
+   for (size_t i = 0; i < n; ++i)
+      v(i) = 1.0 + 0.5 * cos(1.7 * i); // deterministic start vector that is unlikely to be orthogonal to the dominant eigenvector
+   v.normalize();
+
+   eigenvalue = 0.0;
+   spectral_radius = 0.0;
+
+   for (size_t k = 0; k < iterations; ++k)
+   {
+      Eigen::VectorXd w = jacobian(v);
+      double norm = w.norm();
+      if (norm <= 0.0 || simulator.error)
+         return; // the derivatives don't depend upon the states
+      v = w / norm;
+   }
+
+   // For a complex conjugate pair the power iteration does not converge, but v lies within the pair's invariant subspace,
+   // so the eigenvalues are solved from the Krylov vectors v, Jv, JJv: JJv + c0*Jv + c1*v = 0.
+   const Eigen::VectorXd w1 = jacobian(v);
+   const double mu = v.dot(w1); // Rayleigh quotient
+
+   if ((w1 - mu * v).norm() <= 1.0e-3 * w1.norm())
+      eigenvalue = mu;
+   else
+   {
+      const Eigen::VectorXd w2 = jacobian(w1.normalized()) * w1.norm();
+
+      Eigen::MatrixXd K(n, 2);
+      K.col(0) = w1;
+      K.col(1) = v;
+      Eigen::Vector2d c = K.colPivHouseholderQr().solve(-w2);
+
+      complex<double> disc = sqrt(complex<double>(c(0) * c(0) - 4.0 * c(1)));
+      complex<double> r0 = 0.5 * (-c(0) + disc);
+      complex<double> r1 = 0.5 * (-c(0) - disc);
+      eigenvalue = abs(r0) >= abs(r1) ? r0 : r1;
+   }
+
+   spectral_radius = abs(eigenvalue);
+}
+
+bool StepAdvisor::stable(const Candidate& candidate, const double h) const
+{
+   // Private clock, so that the simulator's clock is not affected.
+   double EPS = 1.0e-8, dtp = h, dt = h, t = 0.0, t1 = h;
+   size_t kpass = 0;
+   bool initialized = false;
+   Stepper stepper(EPS, dtp, dt, t, t1, kpass, initialized);
+
+   unique_ptr<State> prototype = candidate.make(stepper);
+
+   // x' = lambda*x for complex lambda, written as a real system
+   double x1 = 1.0, x2 = 0.0, xd1{}, xd2{};
+   unique_ptr<State> s1(prototype->factory(x1, xd1));
+   unique_ptr<State> s2(prototype->factory(x2, xd2));
+
+   const double a = eigenvalue.real(), b = eigenvalue.imag();
+   const double bound = max(1.0, exp(a * h)); // growth per step of the exact solution
+
+   const size_t steps = 200;
+   double norm_half = 0.0;
+   for (size_t i = 0; i < steps; ++i)
+   {
+      do
+      {
+         xd1 = a * x1 - b * x2;
+         xd2 = b * x1 + a * x2;
+         s1->propagate();
+         s2->propagate();
+         prototype->updateClock();
+      } while (kpass != 0);
+
+      dt = h;
+      t1 = t + h;
+
+      if (i == steps / 2 - 1)
+         norm_half = hypot(x1, x2);
+   }
+
+   const double norm = hypot(x1, x2);
+   return isfinite(norm) && norm <= norm_half * pow(bound, steps / 2) * (1.0 + 1.0e-6);
+}
+
+double StepAdvisor::stableStep(const Candidate& candidate) const
+{
+   const double infinity = numeric_limits<double>::infinity();
+
+   if (spectral_radius <= 0.0)
+      return infinity;
+
+   double h_lo = 0.0;
+   double h_hi = 1.0 / spectral_radius;
+   while (stable(candidate, h_hi))
+   {
+      h_lo = h_hi;
+      h_hi *= 2.0;
+      if (h_hi > 1.0e3 / spectral_radius)
+         return infinity;
+   }
+
+   for (size_t i = 0; i < 40; ++i)
+   {
+      const double h = 0.5 * (h_lo + h_hi);
+      if (stable(candidate, h))
+         h_lo = h;
+      else
+         h_hi = h;
+   }
+
+   return h_lo;
+}
+
+bool StepAdvisor::integrate(const Candidate& candidate, const double h, const size_t steps)
+{
+   // Temporary states of the candidate integrator share the model's states and the simulator's clock.
+   unique_ptr<State> prototype = candidate.make(simulator.stepper);
+
+   vector<unique_ptr<State>> temporary;
+   for (State* state : states)
+   {
+      temporary.emplace_back(state->bind(*prototype));
+      if (!temporary.back()) // the candidate doesn't support this state type (i.e. lanes)
+         return false;
+   }
+
+   simulator.kpass = 0;
+   simulator.integrator_initialized = false;
+   simulator.dt = simulator.dtp = h;
+   simulator.t1 = simulator.t + h;
+
+   for (size_t i = 0; i < steps; ++i)
+   {
+      do
+      {
+         simulator.update();
+         for (auto& state : temporary)
+            state->propagate();
+         prototype->updateClock();
+      } while (simulator.kpass != 0 && !simulator.error);
+
+      simulator.dt = h;
+      simulator.t1 = simulator.t + h;
+   }
+
+   return true;
+}
+
+double StepAdvisor::accurateStep(const Candidate& candidate, const double h, const double tolerance)
+{
+   const double infinity = numeric_limits<double>::infinity();
+   const size_t n = states.size();
+   const double t = simulator.t;
+
+   const string x0 = saveStates();
+   vector<double> xa(n);
+
+   if (!integrate(candidate, h, doubling_steps))
+      return 0.0;
+   for (size_t i = 0; i < n; ++i)
+      xa[i] = states[i]->value();
+   loadStates(x0);
+   simulator.t = t;
+
+   integrate(candidate, 0.5 * h, 2 * doubling_steps);
+   simulator.t = t;
+
+   // Richardson estimate of the error over the doubling interval, converted into an error per step.
+   const double p = candidate.order;
+   double e = 0.0;
+   for (size_t i = 0; i < n; ++i)
+   {
+      const double xb = states[i]->value();
+      const double error = abs(xa[i] - xb) / (1.0 - pow(2.0, -p)) / doubling_steps;
+      e = max(e, error / (1.0 + abs(xb)));
+   }
+   loadStates(x0);
+
+   if (!isfinite(e))
+      return 0.0;
+   if (e <= 0.0 || tolerance <= 0.0)
+      return infinity;
+
+   return h * pow(tolerance / e, 1.0 / (p + 1.0));
+}
+
+void StepAdvisor::print(const std::vector<StepAdvice>& advice, std::ostream& stream)
+{
+   stream << left << setw(10) << "Integrator" << setw(16) << "dt stable" << setw(16) << "dt accurate" << "dt" << '\n';
+   for (auto& a : advice)
+      stream << left << setw(10) << a.integrator << setw(16) << a.dt_stable << setw(16) << a.dt_accurate << a.dt() << '\n';
+}
\ No newline at end of file
@@ -16,8 +16,6 @@
 
 using namespace asc;
 
-std::map<std::type_index, std::function<std::string(void* x)>> ToString::print_map;
-
 ToString::ToString()
 {
 
@@ -18,7 +18,8 @@
 
 using namespace asc;
 
-void DOPRI45::propagate()
+template <typename T>
+void DOPRI45T<T>::propagate()
 {
    switch (kpass)
    {
@@ -50,7 +51,8 @@ void DOPRI45::propagate()
    }
 }
 
-void DOPRI45::updateClock()
+template <typename T>
+void DOPRI45T<T>::updateClock()
 {
    if (0 == kpass)
    {
@@ -75,7 +77,8 @@ void DOPRI45::updateClock()
       t1 = floor((t + EPS) / dtp + 1) * dtp;
 }
 
-double DOPRI45::optimalTimeStep()
+template <typename T>
+double DOPRI45T<T>::optimalTimeStep()
 {
    double s = -1.0; // optimal time interval, return a negative value if a computation cannot be performed because of a lack of error
 
@@ -83,7 +86,7 @@ double DOPRI45::optimalTimeStep()
    {
       // After the next update() call we have the next derivative to compute the 4th order solution and thus an error.
       // However, this optimalTimeStep() call needs to happen between update() and propagate(), unlike the DOPRI87 method.
-      double x4th = x0 + dt * (5179.0 / 57600.0 * xd0 + 7571.0 / 16695.0 * xd2 + 393.0 / 640.0 * xd3 - 92097.0 / 339200.0 * xd4 + 187.0 / 2100.0 * xd5 + 1.0 / 40.0 * xd);
+      T x4th = x0 + dt * (5179.0 / 57600.0 * xd0 + 7571.0 / 16695.0 * xd2 + 393.0 / 640.0 * xd3 - 92097.0 / 339200.0 * xd4 + 187.0 / 2100.0 * xd5 + 1.0 / 40.0 * xd);
       double error = std::abs(x4th - x);
       if (error > 0.0)
          s = 0.9 * tolerance / error;
@@ -94,4 +97,8 @@ double DOPRI45::optimalTimeStep()
    }
 
    return s*dt;
-}
\ No newline at end of file
+}
+
+template class asc::DOPRI45T<float>;
+template class asc::DOPRI45T<double>;
+template class asc::DOPRI45T<long double>;
\ No newline at end of file
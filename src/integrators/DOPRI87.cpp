@@ -19,7 +19,8 @@
 using namespace asc;
 using namespace std;
 
-void DOPRI87::propagate()
+template <typename T>
+void DOPRI87T<T>::propagate()
 {
    switch (kpass)
    {
@@ -79,7 +80,8 @@ void DOPRI87::propagate()
    }
 }
 
-void DOPRI87::updateClock()
+template <typename T>
+void DOPRI87T<T>::updateClock()
 {
    if (0 == kpass)
    {
@@ -115,14 +117,15 @@ void DOPRI87::updateClock()
       t1 = floor((t + EPS) / dtp + 1) * dtp;
 }
 
-double DOPRI87::optimalTimeStep()
+template <typename T>
+double DOPRI87T<T>::optimalTimeStep()
 {
    double s = -1.0; // optimal time interval, return a negative value if a computation cannot be performed because of a lack of error
 
    if (tolerance > 0.0)
    {
       // 7th order:
-      double x7th = x0 + dt * (13451932.0 / 455176623.0 * xd0 - 808719846.0 / 976000145.0 * xd5 + 1757004468.0 / 5645159321.0 * xd6 + 656045339.0 / 265891186.0 * xd7 - 3867574721.0 / 1518517206.0 * xd8 + 465885868.0 / 322736535.0 * xd9 + 53011238.0 / 667516719.0 * xd10 + 2.0 / 45.0 *xd11);
+      T x7th = x0 + dt * (13451932.0 / 455176623.0 * xd0 - 808719846.0 / 976000145.0 * xd5 + 1757004468.0 / 5645159321.0 * xd6 + 656045339.0 / 265891186.0 * xd7 - 3867574721.0 / 1518517206.0 * xd8 + 465885868.0 / 322736535.0 * xd9 + 53011238.0 / 667516719.0 * xd10 + 2.0 / 45.0 *xd11);
       double error = abs(x - x7th);
       if (error > 0.0)
          s = pow((tolerance*dt / (2.0*error)), (1.0 / 8.0)); // optimal time interval
@@ -131,4 +134,8 @@ double DOPRI87::optimalTimeStep()
    }
 
    return s*dt;
-}
\ No newline at end of file
+}
+
+template class asc::DOPRI87T<float>;
+template class asc::DOPRI87T<double>;
+template class asc::DOPRI87T<long double>;
\ No newline at end of file
@@ -16,14 +16,21 @@
 
 using namespace asc;
 
-void Euler::propagate()
+template <typename T>
+void EulerT<T>::propagate()
 {
    x0 = x;
    x = x0 + dt * xd;
 }
 
-void Euler::updateClock()
+template <typename T>
+void EulerT<T>::updateClock()
 {
    t = t1;
    t1 = floor((t + EPS) / dtp + 1) * dtp;
-}
\ No newline at end of file
+}
+
+template class asc::EulerT<float>;
+template class asc::EulerT<double>;
+template class asc::EulerT<long double>;
+template class asc::EulerT<Lanes>;
\ No newline at end of file
@@ -0,0 +1,196 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/integrators/GBS.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace asc;
+using namespace std;
+
+// GBSControl
+size_t GBSControl::work(const size_t j) const
+{
+   size_t passes = 1; // the initial derivative is shared by every sequence
+   for (size_t i = 0; i <= j; ++i)
+      passes += n(i);
+   return passes;
+}
+
+void GBSControl::build()
+{
+   sequence.clear();
+   substep.clear();
+
+   // Pass 0 computes the derivative at the beginning of the step.
+   sequence.push_back(0);
+   substep.push_back(0);
+
+   for (size_t j = 0; j < columns; ++j)
+   {
+      for (size_t m = 1; m <= n(j); ++m)
+      {
+         sequence.push_back(j);
+         substep.push_back(m);
+      }
+   }
+
+   err.assign(columns, 0.0);
+}
+
+void GBSControl::selectOrder()
+{
+   previous_columns = columns;
+
+   if (!reported)
+      return; // no state has a tolerance, so the order remains fixed
+
+   // Choose the number of columns that minimizes the work per unit step, using the step size estimate of each column.
+   size_t j_opt = 1;
+   double w_min = -1.0;
+   for (size_t j = 1; j < columns; ++j)
+   {
+      double e = max(err[j], 1.0e-10);
+      double factor = 0.94 * pow(0.65 / e, 1.0 / (2 * j + 1));
+      factor = min(max(factor, 0.02), 4.0);
+
+      double w = work(j) / factor;
+      if (w_min < 0.0 || w < w_min)
+      {
+         w_min = w;
+         j_opt = j;
+      }
+   }
+
+   size_t k = j_opt + 1;
+   if (j_opt == columns - 1 && err[j_opt] < 1.0) // the highest column converged and was the most efficient, so try a higher order
+      ++k;
+
+   columns = min(max(k, min_columns), max_columns);
+
+   build();
+}
+
+// GBS
+template <typename T>
+void GBST<T>::propagate()
+{
+   if (0 == kpass)
+   {
+      x0 = x;
+      xd0 = xd;
+      z_1 = x0;
+      x = x0 + dt / control->n(0) * xd0; // z1 of the first sequence
+      return;
+   }
+
+   const size_t j = control->sequence[kpass];
+   const size_t m = control->substep[kpass];
+   const size_t n = control->n(j);
+   const double h = dt / n;
+
+   if (m < n)
+   {
+      const T z = z_1 + 2.0 * h * xd; // midpoint rule: z[m + 1] = z[m - 1] + 2*h*f(z[m])
+      z_1 = x;
+      x = z;
+   }
+   else
+   {
+      // Gragg's smoothing step, then Aitken-Neville extrapolation of the new tableau row.
+      T prev = row[0];
+      row[0] = 0.5 * (x + z_1 + h * xd);
+
+      for (size_t l = 1; l <= j; ++l)
+      {
+         const T old = row[l]; // only valid for l < j, overwritten before use otherwise
+         const double ratio = static_cast<double>(n) / control->n(j - l);
+         row[l] = row[l - 1] + (row[l - 1] - prev) / (ratio * ratio - 1.0);
+         prev = old;
+      }
+
+      if (j > 0 && tolerance > 0.0)
+      {
+         err[j] = abs(row[j] - row[j - 1]) / tolerance;
+         control->err[j] = max(control->err[j], err[j]);
+         control->reported = true;
+      }
+
+      if (j + 1 < control->columns)
+      {
+         z_1 = x0;
+         x = x0 + dt / control->n(j + 1) * xd0; // z1 of the next sequence
+      }
+      else
+         x = row[j];
+   }
+}
+
+template <typename T>
+void GBST<T>::updateClock()
+{
+   if (0 == kpass)
+   {
+      t0 = t;
+      fill(control->err.begin(), control->err.end(), 0.0);
+      control->reported = false;
+   }
+
+   ++kpass;
+
+   if (kpass == control->passes())
+   {
+      // The last pass evaluated the derivative at t1.
+      kpass = 0;
+      t1 = floor((t + EPS) / dtp + 1) * dtp;
+      control->selectOrder();
+   }
+   else
+   {
+      const size_t n = control->n(control->sequence[kpass]);
+      const size_t m = control->substep[kpass];
+      if (m == n)
+         t = t1;
+      else
+         t = t0 + m * dt / n;
+   }
+}
+
+template <typename T>
+double GBST<T>::optimalTimeStep()
+{
+   double s = -1.0; // optimal time interval, return a negative value if a computation cannot be performed because of a lack of error
+
+   if (tolerance > 0.0)
+   {
+      const size_t k = control->columns;
+      const size_t k_prev = control->previous_columns;
+
+      // Use the step size estimate of the selected column, or scale the last column's estimate by the extra work when the order increased.
+      size_t j = min(k, k_prev) - 1;
+      double e = max(err[j], 1.0e-10);
+      s = 0.94 * pow(0.65 / e, 1.0 / (2 * j + 1));
+      s = min(max(s, 0.02), 4.0);
+
+      if (k > k_prev)
+         s *= static_cast<double>(control->work(k - 1)) / control->work(k_prev - 1);
+   }
+
+   return s*dt;
+}
+
+template class asc::GBST<float>;
+template class asc::GBST<double>;
+template class asc::GBST<long double>;
\ No newline at end of file
@@ -17,7 +17,8 @@
 using namespace asc;
 using namespace std;
 
-void PC233::propagate()
+template <typename T>
+void PC233T<T>::propagate()
 {
    if (!integrator_initialized)
    {
@@ -50,7 +51,8 @@ void PC233::propagate()
    }
 }
 
-void PC233::updateClock()
+template <typename T>
+void PC233T<T>::updateClock()
 {
    // Called once per integration stage
    // Do not perform operations specific to a state here
@@ -77,4 +79,9 @@ void PC233::updateClock()
       if (kpass == 0)
          t1 = floor((t + EPS) / dtp + 1) * dtp;
    }
-}
\ No newline at end of file
+}
+
+template class asc::PC233T<float>;
+template class asc::PC233T<double>;
+template class asc::PC233T<long double>;
+template class asc::PC233T<Lanes>;
\ No newline at end of file
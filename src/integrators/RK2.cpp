@@ -16,7 +16,8 @@
 
 using namespace asc;
 
-void RK2::propagate()
+template <typename T>
+void RK2T<T>::propagate()
 {
    switch (kpass)
    {
@@ -30,7 +31,8 @@ void RK2::propagate()
    }
 }
 
-void RK2::updateClock()
+template <typename T>
+void RK2T<T>::updateClock()
 {
    if (kpass == 0)
       t += 0.5 * dt;
@@ -41,4 +43,9 @@ void RK2::updateClock()
    kpass = kpass % 2;
    if (kpass == 0)
       t1 = floor((t + EPS) / dtp + 1) * dtp;
-}
\ No newline at end of file
+}
+
+template class asc::RK2T<float>;
+template class asc::RK2T<double>;
+template class asc::RK2T<long double>;
+template class asc::RK2T<Lanes>;
\ No newline at end of file
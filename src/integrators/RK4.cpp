@@ -16,7 +16,8 @@
 
 using namespace asc;
 
-void RK4::propagate()
+template <typename T>
+void RK4T<T>::propagate()
 {
    switch (kpass)
    {
@@ -40,7 +41,8 @@ void RK4::propagate()
    }
 }
 
-void RK4::updateClock()
+template <typename T>
+void RK4T<T>::updateClock()
 {
    if (kpass == 0)
       t += 0.5*dt;
@@ -52,4 +54,9 @@ void RK4::updateClock()
 
    if (kpass == 0)
       t1 = floor((t + EPS) / dtp + 1) * dtp;
-}
\ No newline at end of file
+}
+
+template class asc::RK4T<float>;
+template class asc::RK4T<double>;
+template class asc::RK4T<long double>;
+template class asc::RK4T<Lanes>;
\ No newline at end of file
@@ -16,7 +16,8 @@
 
 using namespace asc;
 
-void RKMM::propagate()
+template <typename T>
+void RKMMT<T>::propagate()
 {
    switch (kpass)
    {
@@ -44,7 +45,8 @@ void RKMM::propagate()
    }
 }
 
-void RKMM::updateClock()
+template <typename T>
+void RKMMT<T>::updateClock()
 {
    if (kpass == 0)
       t += dt / 3;
@@ -57,4 +59,9 @@ void RKMM::updateClock()
    kpass = kpass % 5;
    if (kpass == 0)
       t1 = floor((t + EPS) / dtp + 1) * dtp;
-}
\ No newline at end of file
+}
+
+template class asc::RKMMT<float>;
+template class asc::RKMMT<double>;
+template class asc::RKMMT<long double>;
+template class asc::RKMMT<Lanes>;
\ No newline at end of file
@@ -17,7 +17,8 @@
 using namespace asc;
 using namespace std;
 
-void RTAM2::propagate()
+template <typename T>
+void RTAM2T<T>::propagate()
 {
    if (!integrator_initialized)
    {
@@ -42,7 +43,8 @@ void RTAM2::propagate()
    }
 }
 
-void RTAM2::updateClock()
+template <typename T>
+void RTAM2T<T>::updateClock()
 {
    // Called once per integration stage
    // Do not perform operations specific to a state here
@@ -66,4 +68,9 @@ void RTAM2::updateClock()
       if (kpass == 0)
          t1 = floor((t + EPS) / dtp + 1) * dtp;
    }
-}
\ No newline at end of file
+}
+
+template class asc::RTAM2T<float>;
+template class asc::RTAM2T<double>;
+template class asc::RTAM2T<long double>;
+template class asc::RTAM2T<Lanes>;
\ No newline at end of file
@@ -17,13 +17,13 @@
 using namespace asc;
 using namespace std;
 
-void RTAM3::propagate()
+template <typename T>
+void RTAM3T<T>::propagate()
 {
    if (!integrator_initialized)
    {
-      if (0 == kpass && 0 == init_step)
-         xd_1 = xd;
-      else if (0 == kpass && 1 == init_step)
+      // init_step is only counted by the simulator's integrator (updateClock()), so the derivative history is shifted at every initialization step.
+      if (0 == kpass)
       {
          xd_2 = xd_1;
          xd_1 = xd;
@@ -49,7 +49,8 @@ void RTAM3::propagate()
    }
 }
 
-void RTAM3::updateClock()
+template <typename T>
+void RTAM3T<T>::updateClock()
 {
    // Called once per integration pass
 
@@ -75,4 +76,9 @@ void RTAM3::updateClock()
       if (kpass == 0)
          t1 = floor((t + EPS) / dtp + 1) * dtp;
    }
-}
\ No newline at end of file
+}
+
+template class asc::RTAM3T<float>;
+template class asc::RTAM3T<double>;
+template class asc::RTAM3T<long double>;
+template class asc::RTAM3T<Lanes>;
\ No newline at end of file
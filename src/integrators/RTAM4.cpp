@@ -17,18 +17,13 @@
 using namespace asc;
 using namespace std;
 
-void RTAM4::propagate()
+template <typename T>
+void RTAM4T<T>::propagate()
 {
    if (!integrator_initialized)
    {
-      if (0 == kpass && 0 == init_step)
-         xd_1 = xd;
-      else if (0 == kpass && 1 == init_step)
-      {
-         xd_2 = xd_1;
-         xd_1 = xd;
-      }
-      else if (0 == kpass && 2 == init_step)
+      // init_step is only counted by the simulator's integrator (updateClock()), so the derivative history is shifted at every initialization step.
+      if (0 == kpass)
       {
          xd_3 = xd_2;
          xd_2 = xd_1;
@@ -56,7 +51,8 @@ void RTAM4::propagate()
    }
 }
 
-void RTAM4::updateClock()
+template <typename T>
+void RTAM4T<T>::updateClock()
 {
    // Called once per integration pass
 
@@ -82,4 +78,9 @@ void RTAM4::updateClock()
       if (kpass == 0)
          t1 = floor((t + EPS) / dtp + 1) * dtp;
    }
-}
\ No newline at end of file
+}
+
+template class asc::RTAM4T<float>;
+template class asc::RTAM4T<double>;
+template class asc::RTAM4T<long double>;
+template class asc::RTAM4T<Lanes>;
\ No newline at end of file
@@ -0,0 +1,141 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/modules/LinearSystem.h"
+#include "ascent/core/Binary.h"
+
+#include <unsupported/Eigen/MatrixFunctions>
+
+#include <cmath>
+
+using namespace asc;
+
+LinearSystem::LinearSystem(size_t sim, const Eigen::MatrixXd& A, const Eigen::MatrixXd& B, const Eigen::MatrixXd& C, const Eigen::MatrixXd& D)
+   : Module(sim), A(A), B(B), C(C), D(D)
+{
+   x = Eigen::VectorXd::Zero(A.rows());
+   u = Eigen::VectorXd::Zero(B.cols());
+   y = Eigen::VectorXd::Zero(C.rows());
+}
+
+void LinearSystem::init()
+{
+   const auto n = A.rows();
+   const auto m = B.cols();
+
+   if (A.cols() != n || B.rows() != n || C.cols() != n || D.rows() != C.rows() || D.cols() != m)
+      error("LinearSystem: The dimensions of the A, B, C, and D matrices are inconsistent.");
+   else if (x.size() != n || u.size() != m)
+      error("LinearSystem: The sizes of the state or input vectors don't match the system matrices.");
+
+   x0 = x;
+   u0 = u;
+   t0 = t;
+}
+
+void LinearSystem::update()
+{
+   if (sample())
+   {
+      x0 = x;
+      u0 = u;
+      t0 = t;
+   }
+   else if (!freeze_integration)
+      propagate();
+
+   y = C*x + D*u;
+}
+
+void LinearSystem::postcalc()
+{
+   if (!freeze_integration)
+      propagate();
+}
+
+void LinearSystem::checkpoint(std::ostream& stream)
+{
+   std::vector<double> steps; // the discretization keys
+   for (auto& d : discretizations)
+      steps.push_back(d.h);
+
+   Binary::write(stream, x, u, y, x0, u0, t0, steps);
+}
+
+bool LinearSystem::restore(std::istream& stream)
+{
+   std::vector<double> steps;
+   if (!Binary::read(stream, x, u, y, x0, u0, t0, steps))
+      return false;
+
+   discretizations.clear();
+   for (double h : steps)
+      discretization(h);
+   return true;
+}
+
+void LinearSystem::captureValues(std::vector<double>& values)
+{
+   values.insert(values.end(), x.data(), x.data() + x.size());
+   values.insert(values.end(), u.data(), u.data() + u.size());
+   values.insert(values.end(), y.data(), y.data() + y.size());
+}
+
+size_t LinearSystem::seedValues(const std::vector<double>& values, const size_t i)
+{
+   const size_t n = static_cast<size_t>(x.size());
+   const size_t m = static_cast<size_t>(u.size());
+   const size_t p = static_cast<size_t>(y.size());
+   if (i + n + m + p > values.size())
+      return values.size();
+
+   x = Eigen::Map<const Eigen::VectorXd>(&values[i], x.size());
+   u = Eigen::Map<const Eigen::VectorXd>(&values[i + n], u.size());
+   y = Eigen::Map<const Eigen::VectorXd>(&values[i + n + m], y.size());
+   return i + n + m + p;
+}
+
+void LinearSystem::propagate()
+{
+   const double h = t - t0;
+   if (h <= 0.0)
+      return;
+
+   const Discretization& d = discretization(h);
+   x = d.Phi*x0 + d.Gamma*u0;
+}
+
+const LinearSystem::Discretization& LinearSystem::discretization(const double h)
+{
+   for (auto& d : discretizations)
+   {
+      if (std::abs(d.h - h) <= 1.0e-12 * h)
+         return d;
+   }
+
+   if (discretizations.size() >= max_discretizations)
+      discretizations.clear(); // the time step has changed
+
+   const auto n = A.rows();
+   const auto m = B.cols();
+
+   Eigen::MatrixXd M = Eigen::MatrixXd::Zero(n + m, n + m);
+   M.topLeftCorner(n, n) = A*h;
+   M.topRightCorner(n, m) = B*h;
+
+   const Eigen::MatrixXd E = M.exp();
+
+   discretizations.push_back({ h, E.topLeftCorner(n, n), E.topRightCorner(n, m) });
+   return discretizations.back();
+}
\ No newline at end of file
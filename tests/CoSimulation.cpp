@@ -0,0 +1,101 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A subsystem that fails partway through a co-simulation stops every subsystem at the same sync point. The slow subsystem is the last to
+// reach each barrier and fails right after one, so a faster subsystem that already saw the failure mustn't leave it waiting at the next barrier.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+#include "ascent/parallel/CoSimulation.h"
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+
+using namespace asc;
+
+namespace
+{
+   struct Fast : Module
+   {
+      double x = 0.0, xd = 1.0;
+
+      Fast(size_t sim) : Module(sim)
+      {
+         addIntegrator(x, xd);
+         define("x", x);
+      }
+   };
+
+   struct Failing : Module // takes a while for every update(), fails at the sync point t_fail
+   {
+      double x = 0.0, xd = 1.0, input = 0.0;
+      double t_fail = 0.3;
+
+      Failing(size_t sim) : Module(sim)
+      {
+         addIntegrator(x, xd);
+         define("input", input);
+      }
+
+      void update()
+      {
+         if (t >= t_fail)
+            error("Failing::update - failed on purpose.");
+         else
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+   };
+}
+
+int main()
+{
+   for (size_t trial = 0; trial < 20; ++trial)
+   {
+      Link<Fast> fast(2 * trial);
+      Link<Failing> failing(2 * trial + 1);
+
+      CoSimulation co;
+      co.add(fast, 0.01);
+      co.add(failing, 0.01);
+      co.connect(fast, "x", failing, "input");
+
+      std::promise<bool> result;
+      std::future<bool> done = result.get_future();
+      std::thread runner([&] { result.set_value(co.run(0.05, 1.0)); });
+
+      if (done.wait_for(std::chrono::seconds(30)) != std::future_status::ready)
+      {
+         std::cerr << "The co-simulation deadlocked after a subsystem failed.\n";
+         runner.detach();
+         return 1;
+      }
+      runner.join();
+
+      if (done.get())
+      {
+         std::cerr << "The co-simulation didn't report the failed subsystem.\n";
+         return 1;
+      }
+
+      if (fast->t > failing->t_fail + 0.05 + 1e-9)
+      {
+         std::cerr << "A subsystem ran on to t = " << fast->t << " after the other subsystem failed.\n";
+         return 1;
+      }
+   }
+
+   return 0;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// An Euler group completes its step at the first of RK4's four passes. The update() passes at RK4's later stage times must see the
+// group's states at those times, not at the end of the step, or the groups are coupled inconsistently.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+#include "ascent/integrators/Euler.h"
+#include "ascent/integrators/RK4.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace asc;
+
+namespace
+{
+   struct Clock : Module // y = t, integrated by Euler (exactly, since its derivative is constant)
+   {
+      double y = 0.0, yd = 1.0;
+
+      Clock(size_t sim) : Module(sim)
+      {
+         useIntegrator<Euler>();
+         addIntegrator(y, yd);
+      }
+   };
+
+   struct Integral : Module // z = t^2 / 2, integrated by RK4 from the Euler group's y
+   {
+      Link<Clock> clock;
+      double z = 0.0, zd = 0.0;
+      double mismatch = 0.0; // largest difference between y and the time of a pass
+
+      Integral(size_t sim) : Module(sim), clock(sim)
+      {
+         addIntegrator(z, zd);
+         runBefore(clock);
+      }
+
+      void update()
+      {
+         mismatch = std::max(mismatch, std::fabs(clock->y - t));
+         zd = clock->y;
+      }
+   };
+}
+
+int main()
+{
+   integrator<RK4>(0);
+   Link<Integral> integral(0);
+   if (!integral->run(0.1, 1.0))
+   {
+      std::cerr << "The simulation failed.\n";
+      return 1;
+   }
+
+   if (integral->mismatch > 1e-12)
+   {
+      std::cerr << "update() saw the Euler group's state off by " << integral->mismatch << " from the time of its pass.\n";
+      return 1;
+   }
+
+   if (std::fabs(integral->clock->y - 1.0) > 1e-12 || std::fabs(integral->z - 0.5) > 1e-12)
+   {
+      std::cerr << "At t = 1, y = " << integral->clock->y << " and z = " << integral->z << " rather than 1 and 0.5.\n";
+      return 1;
+   }
+
+   return 0;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Lanes of a lockstep ensemble stop one at a time: a stopped lane holds its state, even under a multistep integrator, while the other
+// lanes run on, and the simulation stops once every lane has stopped.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+#include "ascent/integrators/RTAM3.h"
+
+#include <iostream>
+
+using namespace asc;
+
+namespace
+{
+   struct Ensemble : Module // each lane accelerates at its own rate and stops past a distance
+   {
+      Lanes x = Lanes::Zero(), v = Lanes::Zero(), a = Lanes::Zero();
+      Lanes x_stop = Lanes::Zero(), v_stop = Lanes::Zero();
+      double distance = 1.0;
+
+      Ensemble(size_t sim) : Module(sim)
+      {
+         addIntegrator(x, v);
+         addIntegrator(v, a);
+         addStopper(*this);
+         for (Eigen::Index i = 0; i < x.size(); ++i)
+            a(i) = 2.0 + static_cast<double>(i);
+      }
+
+      void check()
+      {
+         for (Eigen::Index i = 0; i < x.size(); ++i)
+         {
+            if (!stop_lanes(i) && x(i) >= distance)
+            {
+               stop_lanes(i) = true;
+               x_stop(i) = x(i);
+               v_stop(i) = v(i);
+            }
+         }
+      }
+   };
+}
+
+int main()
+{
+   const double dt = 0.01;
+
+   integrator<RTAM3>(0);
+   Link<Ensemble> ensemble(0);
+   if (!ensemble->run(dt, 10.0))
+   {
+      std::cerr << "The simulation failed.\n";
+      return 1;
+   }
+
+   if (!ensemble->stop_lanes.all() || !ensemble->stop)
+   {
+      std::cerr << "Not every lane stopped.\n";
+      return 1;
+   }
+
+   if ((ensemble->x != ensemble->x_stop).any() || (ensemble->v != ensemble->v_stop).any())
+   {
+      std::cerr << "A stopped lane moved on.\n";
+      return 1;
+   }
+
+   if (ensemble->t > 1.0 + 2.0 * dt) // the slowest lane reaches the distance at t = 1
+   {
+      std::cerr << "The simulation ran on to t = " << ensemble->t << " after every lane stopped.\n";
+      return 1;
+   }
+
+   return 0;
+}
\ No newline at end of file
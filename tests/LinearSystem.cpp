@@ -0,0 +1,88 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A LinearSystem's state isn't integrated, so it must be carried by its own checkpoint() and restore(): a model restored from a mid-run
+// checkpoint has to continue on the same trajectory as the model that wrote it.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+#include "ascent/modules/LinearSystem.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace asc;
+
+namespace
+{
+   struct Controller : Module // closes a feedback loop around a damped oscillator and records its trajectory
+   {
+      Link<LinearSystem> plant;
+      std::vector<double> trajectory;
+
+      Controller(size_t sim) : Module(sim), plant(sim)
+      {
+         Eigen::MatrixXd A(2, 2), B(2, 1), C(1, 2), D(1, 1);
+         A << 0.0, 1.0, -4.0, -0.2;
+         B << 0.0, 1.0;
+         C << 1.0, 0.0;
+         D << 0.0;
+         plant = Link<LinearSystem>(sim, A, B, C, D);
+         plant->x << 1.0, 0.0;
+         runBefore(plant);
+      }
+
+      void update() { plant->u(0) = -0.5 * plant->y(0) + 0.1 * t; }
+
+      void report()
+      {
+         trajectory.push_back(plant->x(0));
+         trajectory.push_back(plant->x(1));
+      }
+   };
+}
+
+int main()
+{
+   const double dt = 0.01;
+
+   Link<Controller> reference(0);
+   reference->run(dt, 1.0);
+
+   std::stringstream checkpoint;
+   if (!reference->saveCheckpoint(checkpoint))
+   {
+      std::cerr << "The checkpoint couldn't be written.\n";
+      return 1;
+   }
+
+   reference->trajectory.clear();
+   reference->run(dt, 2.0);
+
+   Link<Controller> restored(1);
+   if (!restored->loadCheckpoint(checkpoint))
+   {
+      std::cerr << "The checkpoint couldn't be restored.\n";
+      return 1;
+   }
+   restored->run(dt, 2.0);
+
+   if (restored->trajectory != reference->trajectory)
+   {
+      std::cerr << "The restored LinearSystem diverged from the reference trajectory.\n";
+      return 1;
+   }
+   return 0;
+}
\ No newline at end of file
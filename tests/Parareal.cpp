@@ -0,0 +1,76 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Parareal reuses its coarse and fine simulators for every slice run, so their histories must not grow with the slices, iterations,
+// and repeated run() calls: each model holds at most the history of one slice.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+#include "ascent/integrators/RK2.h"
+#include "ascent/integrators/RK4.h"
+#include "ascent/parallel/Parareal.h"
+
+#include <iostream>
+
+using namespace asc;
+
+namespace
+{
+   struct Oscillator : Module // records the history of x
+   {
+      double x = 1.0, v = 0.0, a = 0.0;
+
+      Oscillator(size_t sim) : Module(sim)
+      {
+         addIntegrator(x, v);
+         addIntegrator(v, a);
+         define("x", x);
+         steps("x", true);
+      }
+
+      void update() { a = -4.0 * x - 0.2 * v; }
+   };
+}
+
+int main()
+{
+   const size_t slices = 4;
+   const double dt_fine = 1.0e-3, tend = 2.0;
+   const size_t slice_steps = static_cast<size_t>(tend / slices / dt_fine + 0.5);
+
+   Parareal<RK2, RK4> parareal([](size_t sim) { return Link<Module>(Link<Oscillator>(sim)); }, slices, 0);
+   parareal.threads = 1;
+
+   for (size_t run = 0; run < 3; ++run)
+   {
+      parareal.coarse->seedStates({ 1.0, 0.0 }, 0.0);
+      if (!parareal.run(0.05, dt_fine, tend))
+      {
+         std::cerr << "Parareal failed.\n";
+         return 1;
+      }
+   }
+
+   for (auto& model : parareal.fine)
+   {
+      const size_t n = model->history<double>("x").size();
+      if (n == 0 || n > slice_steps + 1 || model->timeHistory().size() != n)
+      {
+         std::cerr << "A fine model recorded " << n << " values of x and " << model->timeHistory().size() << " times, for slices of " << slice_steps << " steps.\n";
+         return 1;
+      }
+   }
+
+   return 0;
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Several ports per worker must each keep their own slot of the shared double buffers, across consecutive sync points.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+#include "ascent/parallel/Partition.h"
+
+#include <cmath>
+#include <iostream>
+
+using namespace asc;
+
+namespace
+{
+   const double dt = 0.01;
+   const double macro_step = 0.1;
+   const double tend = 0.3;
+
+   struct Source : Module // publishes a, b, and c, which are offsets of time
+   {
+      double a = 1.0, b = 2.0, c = 3.0;
+
+      Source(size_t sim) : Module(sim)
+      {
+         define("a", a);
+         define("b", b);
+         define("c", c);
+      }
+
+      void postcalc()
+      {
+         a = t + 1.0;
+         b = t + 2.0;
+         c = t + 3.0;
+      }
+   };
+
+   struct Sink : Module // receives a, b, and c, and publishes d
+   {
+      double a = 0.0, b = 0.0, c = 0.0, d = -1.0;
+
+      Sink(size_t sim) : Module(sim)
+      {
+         define("a", a);
+         define("b", b);
+         define("c", c);
+         define("d", d);
+      }
+   };
+
+   bool check(Partition& partition, const std::string& key, const double offset)
+   {
+      const std::vector<double>& x = partition.results[key];
+      const std::vector<double>& t = partition.times[key];
+      if (x.size() != static_cast<size_t>(std::round(tend / dt)) + 1 || t.size() != x.size())
+      {
+         std::cerr << key << ": " << x.size() << " values, " << t.size() << " times\n";
+         return false;
+      }
+
+      size_t sync_points = 0;
+      for (size_t i = 1; i < x.size(); ++i)
+      {
+         const double t_sync = (std::ceil(t[i] / macro_step - 1.0e-8) - 1.0) * macro_step; // the sync point whose inputs are held at t[i]
+         if (std::abs(x[i] - (t_sync + offset)) > 1.0e-9)
+         {
+            std::cerr << key << " at t = " << t[i] << " is " << x[i] << ", expected " << t_sync + offset << '\n';
+            return false;
+         }
+         if (x[i] != x[i - 1])
+            ++sync_points;
+      }
+      return sync_points >= 2;
+   }
+}
+
+int main()
+{
+   Partition partition(2);
+   partition.port("a", 0);
+   partition.port("b", 0);
+   partition.port("c", 0);
+   partition.port("d", 1);
+
+   if (partition.port("a", 1))
+   {
+      std::cerr << "A duplicate port was accepted.\n";
+      return 1;
+   }
+
+   const bool ok = partition.run([](size_t worker, Partition& p) -> Link<Module>
+   {
+      if (worker == 0)
+      {
+         Link<Source> source(0);
+         p.output(source, "a", "a");
+         p.output(source, "b", "b");
+         p.output(source, "c", "c");
+         return source;
+      }
+
+      Link<Sink> sink(0);
+      p.input(sink, "a", "a");
+      p.input(sink, "b", "b");
+      p.input(sink, "c", "c");
+      p.output(sink, "d", "d");
+      p.gather(sink, "a", "a");
+      p.gather(sink, "b", "b");
+      p.gather(sink, "c", "c");
+      return sink;
+   }, dt, macro_step, tend);
+
+   if (!ok || !check(partition, "a", 1.0) || !check(partition, "b", 2.0) || !check(partition, "c", 3.0))
+   {
+      std::cerr << "Partition test failed.\n";
+      return 1;
+   }
+   return 0;
+}
\ No newline at end of file
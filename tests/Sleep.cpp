@@ -0,0 +1,77 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A module falls asleep at the end of a full time step, after the reset() of that step, so every pass that called its update() is reset.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+
+#include <iostream>
+
+using namespace asc;
+
+namespace
+{
+   struct Sleeper : Module // counts the passes it runs, falls asleep at t_sleep
+   {
+      double t_sleep = 0.5;
+      size_t updates = 0;
+      size_t resets = 0;
+      bool pending = false; // set in update(), cleared in reset()
+
+      Sleeper(size_t sim) : Module(sim) {}
+
+      void update()
+      {
+         ++updates;
+         pending = true;
+      }
+
+      void check()
+      {
+         if (t >= t_sleep && !asleep())
+            sleep();
+      }
+
+      void reset()
+      {
+         ++resets;
+         pending = false;
+      }
+   };
+}
+
+int main()
+{
+   Link<Sleeper> sleeper(0);
+   if (!sleeper->run(0.01, 1.0))
+   {
+      std::cerr << "The simulation failed.\n";
+      return 1;
+   }
+
+   if (!sleeper->asleep())
+   {
+      std::cerr << "The module didn't fall asleep.\n";
+      return 1;
+   }
+
+   if (sleeper->updates == 0 || sleeper->resets != sleeper->updates || sleeper->pending)
+   {
+      std::cerr << "The module ran update() " << sleeper->updates << " times but reset() " << sleeper->resets << " times before falling asleep.\n";
+      return 1;
+   }
+
+   return 0;
+}
\ No newline at end of file
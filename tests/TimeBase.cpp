@@ -0,0 +1,68 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// With an exact time base, the clock is counted in ticks: rolling a run back to a checkpoint (as Time Warp does) must roll the ticks back
+// with the time and states, or the next step would jump to the end of the step that followed the later time.
+
+#include "ascent/Link.h"
+#include "ascent/Module.h"
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using namespace asc;
+
+namespace
+{
+   struct Ramp : Module
+   {
+      double x = 0.0, xd = 1.0;
+
+      Ramp(size_t sim) : Module(sim) { addIntegrator(x, xd); }
+   };
+}
+
+int main()
+{
+   Link<Ramp> ramp(0);
+   ramp->timeBase(0.001);
+   if (!ramp->begin(0.01, 1.0) || !ramp->advanceTo(0.1))
+   {
+      std::cerr << "The simulation failed.\n";
+      return 1;
+   }
+
+   std::stringstream checkpoint;
+   if (!ramp->saveCheckpoint(checkpoint, false))
+   {
+      std::cerr << "The checkpoint couldn't be written.\n";
+      return 1;
+   }
+
+   if (!ramp->advanceTo(0.5) || !ramp->loadCheckpoint(checkpoint) || !ramp->advanceTo(0.11))
+   {
+      std::cerr << "The simulation couldn't be rolled back.\n";
+      return 1;
+   }
+
+   if (std::fabs(ramp->t - 0.11) > 1e-12 || std::fabs(ramp->x - 0.11) > 1e-12)
+   {
+      std::cerr << "After rolling back to t = 0.1 and advancing to 0.11, t = " << ramp->t << " and x = " << ramp->x << ".\n";
+      return 1;
+   }
+
+   ramp->end();
+   return 0;
+}
\ No newline at end of file